@@ -0,0 +1,301 @@
+/*
+The OpenTRV project licenses this file to you
+under the Apache Licence, Version 2.0 (the "Licence");
+you may not use this file except in compliance
+with the Licence. You may obtain a copy of the Licence at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the Licence is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied. See the Licence for the
+specific language governing permissions and limitations
+under the Licence.
+
+Author(s) / Copyright (s): Damon Hart-Davis 2017
+*/
+
+/*
+  Persistent AES-128-GCM context for repeated use of one key,
+  eg the building key for every secure stats TX.
+  Only encrypt() is wired into the sketch;
+  decrypt() is used by the host test to check encrypt() round trips.
+
+  The AES round keys and the GHASH key H = E_K(0) are kept between calls
+  and only recomputed when a different key is presented,
+  saving the key expansion and one block encryption per frame.
+  With GHASH_TABLE, a 256-byte table of multiples of H is kept too,
+  so that GHASH works 4 bits at a time rather than 1 bit at a time;
+  the table depends on the key so must be in RAM,
+  and only its fixed reduction constants are in PROGMEM.
+
+  The round keys include the key itself,
+  so this trades keeping the key in RAM for speed;
+  clear() wipes it, eg when the key is changed or cleared.
+
+  Nothing branches on key- or data-dependent values:
+  conditional XORs use masks, and table lookups take the same time
+  for any index on AVR (no data cache).
+  Checked against the McGrew/Viega GCM test vectors
+  by util/V0p2_host/AESGCM/AESGCMContext_Test.cpp.
+
+  Portable (no Arduino dependencies) so that host tools can use it.
+  */
+
+#ifndef AESGCM_CONTEXT_H
+#define AESGCM_CONTEXT_H
+
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__AVR__)
+#include <avr/pgmspace.h>
+#endif
+#ifndef PROGMEM
+#define PROGMEM
+#endif
+#ifndef pgm_read_byte
+#define pgm_read_byte(p) (*(const uint8_t *)(p))
+#endif
+
+namespace AESGCMContextImpl
+  {
+  static const uint8_t sbox[256] PROGMEM =
+    {
+    0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5, 0x30, 0x01, 0x67, 0x2b, 0xfe, 0xd7, 0xab, 0x76,
+    0xca, 0x82, 0xc9, 0x7d, 0xfa, 0x59, 0x47, 0xf0, 0xad, 0xd4, 0xa2, 0xaf, 0x9c, 0xa4, 0x72, 0xc0,
+    0xb7, 0xfd, 0x93, 0x26, 0x36, 0x3f, 0xf7, 0xcc, 0x34, 0xa5, 0xe5, 0xf1, 0x71, 0xd8, 0x31, 0x15,
+    0x04, 0xc7, 0x23, 0xc3, 0x18, 0x96, 0x05, 0x9a, 0x07, 0x12, 0x80, 0xe2, 0xeb, 0x27, 0xb2, 0x75,
+    0x09, 0x83, 0x2c, 0x1a, 0x1b, 0x6e, 0x5a, 0xa0, 0x52, 0x3b, 0xd6, 0xb3, 0x29, 0xe3, 0x2f, 0x84,
+    0x53, 0xd1, 0x00, 0xed, 0x20, 0xfc, 0xb1, 0x5b, 0x6a, 0xcb, 0xbe, 0x39, 0x4a, 0x4c, 0x58, 0xcf,
+    0xd0, 0xef, 0xaa, 0xfb, 0x43, 0x4d, 0x33, 0x85, 0x45, 0xf9, 0x02, 0x7f, 0x50, 0x3c, 0x9f, 0xa8,
+    0x51, 0xa3, 0x40, 0x8f, 0x92, 0x9d, 0x38, 0xf5, 0xbc, 0xb6, 0xda, 0x21, 0x10, 0xff, 0xf3, 0xd2,
+    0xcd, 0x0c, 0x13, 0xec, 0x5f, 0x97, 0x44, 0x17, 0xc4, 0xa7, 0x7e, 0x3d, 0x64, 0x5d, 0x19, 0x73,
+    0x60, 0x81, 0x4f, 0xdc, 0x22, 0x2a, 0x90, 0x88, 0x46, 0xee, 0xb8, 0x14, 0xde, 0x5e, 0x0b, 0xdb,
+    0xe0, 0x32, 0x3a, 0x0a, 0x49, 0x06, 0x24, 0x5c, 0xc2, 0xd3, 0xac, 0x62, 0x91, 0x95, 0xe4, 0x79,
+    0xe7, 0xc8, 0x37, 0x6d, 0x8d, 0xd5, 0x4e, 0xa9, 0x6c, 0x56, 0xf4, 0xea, 0x65, 0x7a, 0xae, 0x08,
+    0xba, 0x78, 0x25, 0x2e, 0x1c, 0xa6, 0xb4, 0xc6, 0xe8, 0xdd, 0x74, 0x1f, 0x4b, 0xbd, 0x8b, 0x8a,
+    0x70, 0x3e, 0xb5, 0x66, 0x48, 0x03, 0xf6, 0x0e, 0x61, 0x35, 0x57, 0xb9, 0x86, 0xc1, 0x1d, 0x9e,
+    0xe1, 0xf8, 0x98, 0x11, 0x69, 0xd9, 0x8e, 0x94, 0x9b, 0x1e, 0x87, 0xe9, 0xce, 0x55, 0x28, 0xdf,
+    0x8c, 0xa1, 0x89, 0x0d, 0xbf, 0xe6, 0x42, 0x68, 0x41, 0x99, 0x2d, 0x0f, 0xb0, 0x54, 0xbb, 0x16
+    };
+  // Reduction of the 4 bits shifted out of a GHASH value, XORed into its first two bytes.
+  static const uint8_t last4[16][2] PROGMEM =
+    {
+    {0x00, 0x00}, {0x1c, 0x20}, {0x38, 0x40}, {0x24, 0x60}, {0x70, 0x80}, {0x6c, 0xa0}, {0x48, 0xc0}, {0x54, 0xe0},
+    {0xe1, 0x00}, {0xfd, 0x20}, {0xd9, 0x40}, {0xc5, 0x60}, {0x91, 0x80}, {0x8d, 0xa0}, {0xa9, 0xc0}, {0xb5, 0xe0}
+    };
+  inline uint8_t sub(const uint8_t b) { return(pgm_read_byte(sbox + b)); }
+  // All ones if the low bit of b is set, else zero.
+  inline uint8_t lsbMask(const uint8_t b) { return((uint8_t)-(uint8_t)(b & 1)); }
+  inline uint8_t xtime(const uint8_t b) { return((uint8_t)((b << 1) ^ (lsbMask(b >> 7) & 0x1b))); }
+  // Multiply v by x in GF(2^128), GCM bit order.
+  inline void mulX(uint8_t v[16])
+    {
+    const uint8_t carry = lsbMask(v[15]);
+    for(uint8_t i = 15; i > 0; --i) { v[i] = (uint8_t)((v[i] >> 1) | (v[i-1] << 7)); }
+    v[0] >>= 1;
+    v[0] ^= carry & 0xe1;
+    }
+  }
+
+// GHASH_TABLE selects the 256-byte table of multiples of H.
+template <bool GHASH_TABLE = false>
+class AES128GCMContext final
+  {
+  public:
+    static constexpr uint8_t KEY_BYTES = 16;
+    static constexpr uint8_t IV_BYTES = 12;
+    static constexpr uint8_t TAG_BYTES = 16;
+
+  private:
+    static constexpr uint8_t BLOCK = 16;
+    // Expanded round keys; the first 16 bytes are the key itself.
+    uint8_t rk[11 * BLOCK];
+    // H, and with GHASH_TABLE i.H for each 4-bit i (in GCM bit order, so 8.H is H).
+    uint8_t m[GHASH_TABLE ? 16 : 1][BLOCK];
+    bool keySet;
+
+    void expandKey(const uint8_t *const key)
+      {
+      memcpy(rk, key, KEY_BYTES);
+      uint8_t rcon = 1;
+      for(uint8_t i = KEY_BYTES; i < sizeof(rk); i += 4)
+        {
+        uint8_t t[4] = { rk[i-4], rk[i-3], rk[i-2], rk[i-1] };
+        if(0 == (i % KEY_BYTES))
+          {
+          const uint8_t t0 = t[0];
+          t[0] = (uint8_t)(AESGCMContextImpl::sub(t[1]) ^ rcon);
+          t[1] = AESGCMContextImpl::sub(t[2]);
+          t[2] = AESGCMContextImpl::sub(t[3]);
+          t[3] = AESGCMContextImpl::sub(t0);
+          rcon = AESGCMContextImpl::xtime(rcon);
+          }
+        for(uint8_t j = 0; j < 4; ++j) { rk[i+j] = rk[i+j-KEY_BYTES] ^ t[j]; }
+        }
+      }
+
+    // s = s.H
+    void gmul(uint8_t s[BLOCK]) const
+      {
+      uint8_t z[BLOCK] = { 0 };
+      if(GHASH_TABLE)
+        {
+        // Horner, 4 bits at a time from the highest-degree end.
+        for(int8_t i = BLOCK - 1; i >= 0; --i)
+          {
+          for(uint8_t half = 0; half < 2; ++half)
+            {
+            const uint8_t nibble = half ? (s[i] >> 4) : (s[i] & 0xf);
+            const uint8_t rem = z[BLOCK-1] & 0xf;
+            for(uint8_t j = BLOCK - 1; j > 0; --j) { z[j] = (uint8_t)((z[j] >> 4) | (z[j-1] << 4)); }
+            z[0] >>= 4;
+            z[0] ^= pgm_read_byte(&AESGCMContextImpl::last4[rem][0]);
+            z[1] ^= pgm_read_byte(&AESGCMContextImpl::last4[rem][1]);
+            for(uint8_t j = 0; j < BLOCK; ++j) { z[j] ^= m[nibble][j]; }
+            }
+          }
+        }
+      else
+        {
+        uint8_t v[BLOCK];
+        memcpy(v, m[0], BLOCK);
+        for(uint8_t i = 0; i < BLOCK; ++i)
+          {
+          for(int8_t b = 7; b >= 0; --b)
+            {
+            const uint8_t mask = AESGCMContextImpl::lsbMask(s[i] >> b);
+            for(uint8_t j = 0; j < BLOCK; ++j) { z[j] ^= v[j] & mask; }
+            AESGCMContextImpl::mulX(v);
+            }
+          }
+        }
+      memcpy(s, z, BLOCK);
+      }
+
+    // Fold len bytes of data, zero padded to whole blocks, into GHASH state s.
+    void ghash(uint8_t s[BLOCK], const uint8_t *data, uint8_t len) const
+      {
+      while(len > 0)
+        {
+        const uint8_t n = (len < BLOCK) ? len : BLOCK;
+        for(uint8_t i = 0; i < n; ++i) { s[i] ^= data[i]; }
+        gmul(s);
+        data += n;
+        len -= n;
+        }
+      }
+
+    // Shared by encrypt and decrypt: CTR-transform len bytes of in to out,
+    // and compute the tag over the aad and the cipher-text (in or out).
+    void crypt(const uint8_t *const iv, const uint8_t *const aad, const uint8_t aadLen,
+               const uint8_t *const in, const uint8_t len, uint8_t *const out,
+               const bool decrypting, uint8_t tag[TAG_BYTES]) const
+      {
+      uint8_t s[BLOCK] = { 0 };
+      ghash(s, aad, aadLen);
+      if(decrypting) { ghash(s, in, len); }
+      uint8_t ctr[BLOCK], ks[BLOCK];
+      memcpy(ctr, iv, IV_BYTES);
+      ctr[12] = 0; ctr[13] = 0; ctr[14] = 0; ctr[15] = 1;
+      for(uint8_t done = 0; done < len; done += BLOCK)
+        {
+        ++ctr[15]; // At most 16 blocks so no carry.
+        encryptBlock(ctr, ks);
+        const uint8_t n = ((len - done) < BLOCK) ? (len - done) : BLOCK;
+        for(uint8_t i = 0; i < n; ++i) { out[done + i] = in[done + i] ^ ks[i]; }
+        }
+      if(!decrypting) { ghash(s, out, len); }
+      // Lengths in bits, 64-bit big-endian each.
+      uint8_t lens[BLOCK] = { 0 };
+      lens[6] = (uint8_t)(aadLen >> 5); lens[7] = (uint8_t)(aadLen << 3);
+      lens[14] = (uint8_t)(len >> 5); lens[15] = (uint8_t)(len << 3);
+      ghash(s, lens, BLOCK);
+      ctr[15] = 1;
+      encryptBlock(ctr, tag);
+      for(uint8_t i = 0; i < TAG_BYTES; ++i) { tag[i] ^= s[i]; }
+      }
+
+  public:
+    AES128GCMContext() : keySet(false) { }
+
+    // Prepare for key, doing nothing if already prepared for it.
+    void setKey(const uint8_t *const key)
+      {
+      if(keySet && (0 == memcmp(rk, key, KEY_BYTES))) { return; }
+      expandKey(key);
+      uint8_t *const h = m[GHASH_TABLE ? 8 : 0];
+      memset(h, 0, BLOCK);
+      encryptBlock(h, h);
+      if(GHASH_TABLE)
+        {
+        memset(m[0], 0, BLOCK);
+        for(uint8_t i = 4; i > 0; i >>= 1) { memcpy(m[i], m[i << 1], BLOCK); AESGCMContextImpl::mulX(m[i]); }
+        for(uint8_t i = 2; i < 16; i <<= 1)
+          { for(uint8_t j = 1; j < i; ++j) { for(uint8_t k = 0; k < BLOCK; ++k) { m[i + j][k] = m[i][k] ^ m[j][k]; } } }
+        }
+      keySet = true;
+      }
+
+    // Wipe the key and everything derived from it.
+    void clear()
+      {
+      for(volatile uint8_t *p = rk; p < rk + sizeof(rk); ++p) { *p = 0; }
+      for(volatile uint8_t *p = &m[0][0]; p < &m[0][0] + sizeof(m); ++p) { *p = 0; }
+      keySet = false;
+      }
+
+    // AES-128 encrypt one block; in and out may be the same.
+    void encryptBlock(const uint8_t *const in, uint8_t *const out) const
+      {
+      uint8_t s[BLOCK];
+      for(uint8_t i = 0; i < BLOCK; ++i) { s[i] = in[i] ^ rk[i]; }
+      for(uint8_t round = 1; round <= 10; ++round)
+        {
+        // SubBytes and ShiftRows together; state is column-major.
+        uint8_t t[BLOCK];
+        for(uint8_t c = 0; c < 4; ++c)
+          { for(uint8_t r = 0; r < 4; ++r) { t[4*c + r] = AESGCMContextImpl::sub(s[4*((c + r) & 3) + r]); } }
+        if(round < 10)
+          {
+          for(uint8_t c = 0; c < 4; ++c)
+            {
+            uint8_t *const col = t + 4*c;
+            const uint8_t a0 = col[0], a1 = col[1], a2 = col[2], a3 = col[3];
+            const uint8_t all = a0 ^ a1 ^ a2 ^ a3;
+            col[0] ^= all ^ AESGCMContextImpl::xtime(a0 ^ a1);
+            col[1] ^= all ^ AESGCMContextImpl::xtime(a1 ^ a2);
+            col[2] ^= all ^ AESGCMContextImpl::xtime(a2 ^ a3);
+            col[3] ^= all ^ AESGCMContextImpl::xtime(a3 ^ a0);
+            }
+          }
+        const uint8_t *const k = rk + BLOCK * round;
+        for(uint8_t i = 0; i < BLOCK; ++i) { s[i] = t[i] ^ k[i]; }
+        }
+      memcpy(out, s, BLOCK);
+      }
+
+    // GCM-AE with a 12-byte IV and 16-byte tag; text up to 255 bytes.
+    // setKey() must have been called.
+    void encrypt(const uint8_t *const iv, const uint8_t *const aad, const uint8_t aadLen,
+                 const uint8_t *const plain, const uint8_t len, uint8_t *const cipherOut, uint8_t *const tagOut) const
+      { crypt(iv, aad, aadLen, plain, len, cipherOut, false, tagOut); }
+
+    // GCM-AD with a 12-byte IV and 16-byte tag; text up to 255 bytes.
+    // setKey() must have been called.
+    // Returns false, with plainOut zeroed, if the tag does not match.
+    bool decrypt(const uint8_t *const iv, const uint8_t *const aad, const uint8_t aadLen,
+                 const uint8_t *const cipher, const uint8_t len, const uint8_t *const tag, uint8_t *const plainOut) const
+      {
+      uint8_t t[TAG_BYTES];
+      crypt(iv, aad, aadLen, cipher, len, plainOut, true, t);
+      uint8_t diff = 0; // Constant time.
+      for(uint8_t i = 0; i < TAG_BYTES; ++i) { diff |= t[i] ^ tag[i]; }
+      if(0 != diff) { memset(plainOut, 0, len); return(false); }
+      return(true);
+      }
+  };
+
+#endif
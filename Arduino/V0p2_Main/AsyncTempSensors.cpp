@@ -0,0 +1,169 @@
+/*
+The OpenTRV project licenses this file to you
+under the Apache Licence, Version 2.0 (the "Licence");
+you may not use this file except in compliance
+with the Licence. You may obtain a copy of the Licence at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the Licence is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied. See the Licence for the
+specific language governing permissions and limitations
+under the Licence.
+
+Author(s) / Copyright (s): Damon Hart-Davis 2017
+*/
+
+/*
+ Two-phase (start/collect) reads for the primary room temperature sensors.
+ */
+
+#include "V0p2_Main.h"
+
+#if defined(ENABLE_ASYNC_TEMP_SENSOR)
+
+#include <Wire.h> // Arduino I2C library.
+#include <util/crc16.h>
+
+static const uint8_t SHT21_I2C_ADDR = 0x40;
+static const uint8_t SHT21_I2C_CMD_TEMP_NOHOLD = 0xf3;
+
+bool RoomTemperatureC16_SHT21_Async::startRead()
+  {
+  Wire.beginTransmission(SHT21_I2C_ADDR);
+  Wire.write((byte) SHT21_I2C_CMD_TEMP_NOHOLD);
+  started = (0 == Wire.endTransmission());
+  return(started);
+  }
+
+bool RoomTemperatureC16_SHT21_Async::collectRead()
+  {
+  if(!started) { return(false); }
+  started = false;
+  // Address is NAKed (nothing read) while the conversion is still running.
+  if(Wire.requestFrom(SHT21_I2C_ADDR, 3U) < 3) { return(false); }
+  uint16_t rawTemp = (Wire.read() << 8);
+  rawTemp |= (Wire.read() & 0xfc); // Clear status ls bits.
+  Wire.read(); // Discard CRC.
+
+  // Nominal formula: C = -46.85 + ((175.72*raw) / (1L << 16));
+  const int c16 = -750 + ((5623L * rawTemp) >> 17);
+
+  // Capture entropy if (transformed) value has changed.
+  if((uint8_t)c16 != (uint8_t)value) { OTV0P2BASE::addEntropyToPool((uint8_t)rawTemp, 0); } // Claim zero entropy as may be forced by Eve.
+
+  value = c16;
+  return(true);
+  }
+
+
+static const uint8_t TMP112_I2C_ADDR = 72;
+static const uint8_t TMP112_REG_TEMP = 0; // Temperature register.
+static const uint8_t TMP112_REG_CTRL = 1; // Control register.
+static const uint8_t TMP112_CTRL_B1 = 0x31; // Byte 1 for control register: 12-bit resolution and shutdown mode (SD).
+static const uint8_t TMP112_CTRL_B1_OS = 0x80; // Control register: one-shot flag in byte 1.
+
+bool RoomTemperatureC16_TMP112_Async::startRead()
+  {
+  started = false;
+  Wire.beginTransmission(TMP112_I2C_ADDR);
+  Wire.write((byte) TMP112_REG_CTRL); // Select control register.
+  Wire.write((byte) TMP112_CTRL_B1); // Clear OS bit.
+  if(Wire.endTransmission()) { return(false); }
+  Wire.beginTransmission(TMP112_I2C_ADDR);
+  Wire.write((byte) TMP112_REG_CTRL); // Select control register.
+  Wire.write((byte) TMP112_CTRL_B1 | TMP112_CTRL_B1_OS); // Start one-shot conversion.
+  started = (0 == Wire.endTransmission());
+  return(started);
+  }
+
+bool RoomTemperatureC16_TMP112_Async::collectRead()
+  {
+  if(!started) { return(false); }
+  started = false;
+  Wire.beginTransmission(TMP112_I2C_ADDR);
+  Wire.write((byte) TMP112_REG_CTRL); // Select control register.
+  if(Wire.endTransmission()) { return(false); }
+  if(Wire.requestFrom(TMP112_I2C_ADDR, 1U) != 1) { return(false); }
+  if(0 == (Wire.read() & TMP112_CTRL_B1_OS)) { return(false); } // Conversion not complete.
+
+  Wire.beginTransmission(TMP112_I2C_ADDR);
+  Wire.write((byte) TMP112_REG_TEMP); // Select temperature register (set ptr to 0).
+  if(Wire.endTransmission()) { return(false); }
+  if(Wire.requestFrom(TMP112_I2C_ADDR, 2U) != 2) { return(false); }
+  const byte b1 = Wire.read(); // MSByte, should be signed whole degrees C.
+  const uint8_t b2 = Wire.read(); // Avoid sign extension...
+
+  // Builds 12-bit value (assumes not in extended mode) and sign-extends if necessary for sub-zero temps.
+  const int t16 = (b1 << 4) | (b2 >> 4) | ((b1 & 0x80) ? 0xf000 : 0);
+
+  // Capture entropy if (transformed) value has changed.
+  if((uint8_t)t16 != (uint8_t)value) { OTV0P2BASE::addEntropyToPool(b1 ^ b2, 0); } // Claim zero entropy as may be forced by Eve.
+
+  value = t16;
+  return(true);
+  }
+
+
+#if defined(ENABLE_MINIMAL_ONEWIRE_SUPPORT)
+static const uint8_t DS18B20_MODEL_ID = 0x28;
+static const uint8_t DS18B20_CMD_START_CONVO = 0x44;
+static const uint8_t DS18B20_CMD_READ_SCRATCH = 0xbe;
+
+bool TemperatureC16_DS18B20_Async::startRead()
+  {
+  started = false;
+  // Finds and configures the device(s) on first use.
+  if(0 == getSensorCount()) { return(false); }
+  if(!haveAddr)
+    {
+    bus.reset_search();
+    while(!haveAddr && bus.search(addr)) { haveAddr = (DS18B20_MODEL_ID == addr[0]); }
+    bus.reset_search(); // Be kind to any other OW search user.
+    if(!haveAddr) { return(false); }
+    }
+  if(!bus.reset()) { return(false); } // Nothing answered.
+  bus.skip();
+  bus.write(DS18B20_CMD_START_CONVO); // Start conversion without parasite power.
+  started = true;
+  return(true);
+  }
+
+bool TemperatureC16_DS18B20_Async::fetch()
+  {
+  // Bus is held low while any conversion is still running.
+  if(0 == bus.read_bit()) { return(false); }
+
+  // Fetch temperature (scratchpad read).
+  // With no device present the bus floats high and would read as 0xffff, ie -1/16C.
+  if(!bus.reset()) { return(false); }
+  bus.select(addr);
+  bus.write(DS18B20_CMD_READ_SCRATCH);
+  // Read all 9 bytes; the Dallas CRC8 over the lot, including the CRC byte itself, is 0 if intact.
+  uint8_t sp[9];
+  uint8_t crc = 0;
+  for(uint8_t i = 0; i < sizeof(sp); ++i) { crc = _crc_ibutton_update(crc, (sp[i] = bus.read())); }
+  // Terminate read and let DS18B20 go back to sleep.
+  bus.reset();
+  if(0 != crc) { return(false); }
+
+  value = (int16_t)((sp[1] << 8) | sp[0]);
+  return(true);
+  }
+
+bool TemperatureC16_DS18B20_Async::collectRead()
+  {
+  const bool wasStarted = started;
+  started = false;
+  if(wasStarted && fetch()) { failedCollects = 0; return(true); }
+  // Report a sensor that has gone missing or bad rather than keep a stale reading.
+  if(++failedCollects < MAX_FAILED_COLLECTS) { return(false); }
+  failedCollects = MAX_FAILED_COLLECTS;
+  value = DEFAULT_INVALID_TEMP;
+  return(true);
+  }
+#endif // defined(ENABLE_MINIMAL_ONEWIRE_SUPPORT)
+
+#endif // defined(ENABLE_ASYNC_TEMP_SENSOR)
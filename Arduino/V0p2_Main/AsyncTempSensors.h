@@ -0,0 +1,108 @@
+/*
+The OpenTRV project licenses this file to you
+under the Apache Licence, Version 2.0 (the "Licence");
+you may not use this file except in compliance
+with the Licence. You may obtain a copy of the Licence at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the Licence is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied. See the Licence for the
+specific language governing permissions and limitations
+under the Licence.
+
+Author(s) / Copyright (s): Damon Hart-Davis 2017
+*/
+
+/*
+  Two-phase (start/collect) reads for the primary room temperature sensors.
+
+  The library read() for each of these blocks while the conversion completes:
+  ~26ms for TMP112, up to 85ms for SHT21 and up to 750ms for a 12-bit DS18B20.
+  Here startRead() kicks off a conversion and returns at once,
+  and collectRead() in a later minor cycle fetches the result,
+  so the CPU sleeps through the conversion at no sub-cycle cost.
+
+  collectRead() returns false, leaving the current value untouched,
+  if no conversion was started or it has not completed or failed;
+  the caller can then fall back to the blocking read(), which still works as before,
+  where that is quick enough (not for the DS18B20).
+
+  Caller must power up TWI (SHT21 and TMP112) around both calls.
+  */
+
+#ifndef ASYNC_TEMP_SENSORS_H
+#define ASYNC_TEMP_SENSORS_H
+
+#include <OTV0p2Base.h>
+
+// SHT21 temperature using the no-hold command:
+// the SHT21 NAKs its address until the conversion completes.
+// Resolution is as set in the device by the library (see HumiditySensorSHT21).
+class RoomTemperatureC16_SHT21_Async final : public OTV0P2BASE::RoomTemperatureC16_SHT21
+  {
+  private:
+    // True from a successful startRead() until the next collectRead().
+    bool started;
+  public:
+    RoomTemperatureC16_SHT21_Async() : started(false) { }
+    // Start a conversion; returns false if the sensor did not respond.
+    bool startRead();
+    // Collect the conversion started by startRead(); returns true iff value was updated.
+    bool collectRead();
+  };
+
+// TMP112 temperature using a one-shot conversion from shutdown mode:
+// the OS bit in the control register reads 1 once the conversion completes.
+class RoomTemperatureC16_TMP112_Async final : public OTV0P2BASE::RoomTemperatureC16_TMP112
+  {
+  private:
+    // True from a successful startRead() until the next collectRead().
+    bool started;
+  public:
+    RoomTemperatureC16_TMP112_Async() : started(false) { }
+    // Start a conversion; returns false if the sensor did not respond.
+    bool startRead();
+    // Collect the conversion started by startRead(); returns true iff value was updated.
+    bool collectRead();
+  };
+
+#if defined(ENABLE_MINIMAL_ONEWIRE_SUPPORT)
+// DS18B20 temperature, reading the first DS18B20 on the bus as read() does.
+// Conversion is started on all devices at once (skip ROM),
+// and the result fetched from the first DS18B20, whose address is found on first use.
+// An externally-powered DS18B20 holds the bus low until its conversion completes.
+// At full precision read() blocks for up to ~750ms, so is not a fallback within a slot.
+// A result is only accepted if the device answers reset and the scratchpad CRC is good;
+// after MAX_FAILED_COLLECTS failures in a row the value is set to DEFAULT_INVALID_TEMP
+// rather than the last reading being kept indefinitely.
+class TemperatureC16_DS18B20_Async final : public OTV0P2BASE::TemperatureC16_DS18B20
+  {
+  public:
+    static const uint8_t MAX_FAILED_COLLECTS = 3;
+  private:
+    // Bus, as held privately by the base class.
+    OTV0P2BASE::MinimalOneWireBase &bus;
+    // Address of the first DS18B20 on the bus, once found.
+    uint8_t addr[8];
+    bool haveAddr;
+    // True from a successful startRead() until the next collectRead().
+    bool started;
+    // Consecutive collectRead() calls without a good reading; saturates at MAX_FAILED_COLLECTS.
+    uint8_t failedCollects;
+    // Fetch and check the completed conversion; returns true iff value was updated.
+    bool fetch();
+  public:
+    TemperatureC16_DS18B20_Async(OTV0P2BASE::MinimalOneWireBase &ow, const uint8_t _precision)
+      : TemperatureC16_DS18B20(ow, _precision), bus(ow), haveAddr(false), started(false), failedCollects(0) { }
+    // Start a conversion; returns false if no DS18B20 is on the bus.
+    bool startRead();
+    // Collect the conversion started by startRead(); returns true iff value was updated,
+    // including to DEFAULT_INVALID_TEMP after too many failures.
+    bool collectRead();
+  };
+#endif // defined(ENABLE_MINIMAL_ONEWIRE_SUPPORT)
+
+#endif
@@ -0,0 +1,64 @@
+/*
+The OpenTRV project licenses this file to you
+under the Apache Licence, Version 2.0 (the "Licence");
+you may not use this file except in compliance
+with the Licence. You may obtain a copy of the Licence at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the Licence is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied. See the Licence for the
+specific language governing permissions and limitations
+under the Licence.
+
+Author(s) / Copyright (s): Damon Hart-Davis 2017
+*/
+
+/*
+  Minimal stackless cooperative jobs (protothreads) for work
+  that may not fit in what is left of one minor cycle.
+
+  A job is a function bracketed by CO_BEGIN()/CO_END()
+  that may CO_YIELD() at safe points,
+  and is re-entered just after that point the next time it is run,
+  typically at the next minor cycle (see runCoJobs() in Control.cpp).
+  Code before CO_BEGIN() runs on every entry.
+
+  Costs 3 bytes of RAM per job and no stack between runs, but:
+    * locals do not survive a yield: keep state in statics;
+    * no switch statement may enclose a yield, and only one yield per source line.
+  */
+
+#ifndef CO_TASK_H
+#define CO_TASK_H
+
+#include <stdint.h>
+
+// State of one cooperative job.
+struct CoTask
+  {
+  // Resume point (source line of last yield), or 0 to run from the top.
+  uint16_t lc;
+  // True from start() until the job completes.
+  bool pending;
+  // Request the job to run from the top, unless it is already pending.
+  void start() { if(!pending) { lc = 0; pending = true; } }
+  // Abandon the job, eg if its work is no longer wanted.
+  void stop() { lc = 0; pending = false; }
+  };
+
+// Job body: returns true when complete, false when yielded.
+// The runner stops a job that returns true, eg from an early exit before CO_BEGIN().
+// stopBy is the sub-cycle time by which the job should have returned.
+typedef bool coJob_fn_t(CoTask &ct, uint8_t stopBy);
+
+#define CO_BEGIN(ct) switch((ct).lc) { case 0:
+// Suspend here and resume at the next run.
+#define CO_YIELD(ct) do { (ct).lc = __LINE__; return(false); case __LINE__:; } while(0)
+// Suspend here unless the current sub-cycle time is before sct.
+#define CO_YIELD_IF_LATE(ct, sct) do { if(OTV0P2BASE::getSubCycleTime() >= (sct)) { CO_YIELD(ct); } } while(0)
+#define CO_END(ct) } (ct).stop(); return(true)
+
+#endif
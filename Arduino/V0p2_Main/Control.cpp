@@ -75,6 +75,24 @@ OTRadValve::ModelledRadValve NominalRadValve(
 #endif // ENABLE_MODELLED_RAD_VALVE
 
 
+// Shared workspace for the large scratch buffers (see WorkspacePlan).
+uint8_t globalWorkSpace[OTV0P2BASE::fnmax((size_t)1, WorkspacePlan::total())];
+
+#if defined(DEBUG)
+uint8_t WorkspaceClaim::live;
+WorkspaceClaim::WorkspaceClaim(const ws_user_t u) : user(u)
+  {
+  if(0 != (live & ~WorkspacePlan::concurrent(u)))
+    {
+    DEBUG_SERIAL_PRINT_FLASHSTRING("!WS clash ");
+    DEBUG_SERIAL_PRINT(u);
+    DEBUG_SERIAL_PRINTLN();
+    }
+  live |= WorkspacePlan::bit(u);
+  }
+#endif // defined(DEBUG)
+
+
 // Call this to do an I/O poll if needed; returns true if something useful definitely happened.
 // This call should typically take << 1ms at 1MHz CPU.
 // Does not change CPU clock speeds, mess with interrupts (other than possible brief blocking), or sleep.
@@ -128,6 +146,7 @@ static void RFM22RawStatsTXFFTerminated(uint8_t * const buf, const bool doubleTX
     DEBUG_SERIAL_PRINT(buflen);
     DEBUG_SERIAL_PRINTLN();
 #endif // DEBUG
+  ENERGY_CHARGE_TX(buflen, doubleTX);
   if(!PrimaryRadio.queueToSend(buf, buflen, 0, (doubleTX ? OTRadioLink::OTRadioLink::TXmax : OTRadioLink::OTRadioLink::TXnormal)))
     {
 #if 0 && defined(DEBUG)
@@ -139,11 +158,170 @@ static void RFM22RawStatsTXFFTerminated(uint8_t * const buf, const bool doubleTX
 #endif // defined(ENABLE_RFM23B_FS20_RAW_PREAMBLE)
 
 
+#if defined(ENABLE_RX_QUEUE_STATS)
+// Most RX frames seen queued at once since last put into stats.
+static uint8_t rxQueueHighWater;
+#endif
 #ifdef ENABLE_STATS_TX
 #if defined(ENABLE_JSON_OUTPUT)
 // Managed JSON stats.
+#if defined(ENABLE_RX_QUEUE_STATS)
+static OTV0P2BASE::SimpleStatsRotation<12 + 3> ss1; // Configured for maximum different stats plus RX queue telemetry.
+#else
 static OTV0P2BASE::SimpleStatsRotation<12> ss1; // Configured for maximum different stats.	// FIXME increased for voice & for setback lockout
+#endif
 #endif // ENABLE_JSON_OUTPUT
+#if defined(ENABLE_ADAPTIVE_STATS_TX)
+// Decides when stats are worth sending, by comparing with what was last sent.
+//   * urgent: call for heat or occupancy changed; send within seconds
+//   * material: a reading has moved noticeably; send in the next regular slot
+//   * heartbeat: nothing sent for a while; send anyway so the hub knows we are alive,
+//     more often while calling for heat so that the boiler is kept on.
+// Otherwise nothing is sent, saving airtime and battery.
+#ifndef STATS_TX_HEARTBEAT_M
+#define STATS_TX_HEARTBEAT_M 15 // Minutes; max gap between frames when idle.
+#endif
+#ifndef STATS_TX_HEARTBEAT_CALLING_M
+#define STATS_TX_HEARTBEAT_CALLING_M 2 // Minutes; max gap while calling for heat, as before.
+#endif
+#ifndef STATS_TX_MATERIAL_C16
+#define STATS_TX_MATERIAL_C16 8 // Temperature change (C*16) worth reporting, ie 0.5C.
+#endif
+#ifndef STATS_TX_MAX_PER_MINUTE
+#define STATS_TX_MAX_PER_MINUTE 2 // Frames; lets an urgent change out in the minute of a send, but bounds flapping.
+#endif
+class StatsTXPolicy final
+  {
+  private:
+    int16_t lastTempC16;
+    uint8_t lastValvePC;
+    uint8_t lastTargetC;
+    uint8_t lastOcc;
+    bool lastCallingForHeat;
+    // Whole minutes since the last frame; saturates.
+    uint8_t minutesSinceTX;
+    // Frames sent since the start of this minute.
+    uint8_t framesThisMinute;
+    // Gets current call-for-heat state.
+    static bool callingForHeat()
+      {
+#if defined(ENABLE_NOMINAL_RAD_VALVE)
+      return(NominalRadValve.isControlledValveReallyOpen());
+#else
+      return(false);
+#endif
+      }
+    // Gets current two-bit occupancy, 0 if not supported.
+    static uint8_t occ()
+      {
+#if defined(ENABLE_OCCUPANCY_SUPPORT)
+      return(Occupancy.twoBitOccupancyValue());
+#else
+      return(0);
+#endif
+      }
+
+  public:
+    enum Need : uint8_t { NONE, MATERIAL, URGENT };
+    // Start as if a heartbeat is due, so as to send promptly after power-up.
+    StatsTXPolicy() : lastTempC16(0), lastValvePC(0), lastTargetC(0), lastOcc(0), lastCallingForHeat(false), minutesSinceTX(255), framesThisMinute(0) { }
+    // Call once per minute.
+    void tickMinute() { if(minutesSinceTX < 255) { ++minutesSinceTX; } framesThisMinute = 0; }
+    // How much a frame is needed now.
+    Need need() const
+      {
+      // Urgent changes go out even in the minute of another frame, up to a small limit.
+      const uint8_t o = occ();
+      if(framesThisMinute < STATS_TX_MAX_PER_MINUTE)
+        {
+        if(callingForHeat() != lastCallingForHeat) { return(URGENT); }
+        // Becoming or ceasing to be likely occupied (3).
+        if((3 == o) != (3 == lastOcc)) { return(URGENT); }
+        }
+      if(0 == minutesSinceTX) { return(NONE); } // Else at most one frame per minute.
+      if(minutesSinceTX >= (lastCallingForHeat ? STATS_TX_HEARTBEAT_CALLING_M : STATS_TX_HEARTBEAT_M)) { return(MATERIAL); }
+      const int16_t dT = TemperatureC16.get() - lastTempC16;
+      if((dT >= STATS_TX_MATERIAL_C16) || (dT <= -STATS_TX_MATERIAL_C16)) { return(MATERIAL); }
+      if(o != lastOcc) { return(MATERIAL); }
+#if defined(ENABLE_NOMINAL_RAD_VALVE)
+      const uint8_t v = NominalRadValve.get();
+      if((v > lastValvePC + 10) || (v + 10 < lastValvePC)) { return(MATERIAL); }
+#endif
+#if defined(ENABLE_LOCAL_TRV)
+      if(NominalRadValve.targetTemperatureSubSensor.get() != lastTargetC) { return(MATERIAL); }
+#endif
+      return(NONE);
+      }
+    // Call when a frame has been sent to snapshot what the receiver now knows.
+    void sent()
+      {
+      minutesSinceTX = 0;
+      if(framesThisMinute < 255) { ++framesThisMinute; }
+      lastTempC16 = TemperatureC16.get();
+      lastOcc = occ();
+      lastCallingForHeat = callingForHeat();
+#if defined(ENABLE_NOMINAL_RAD_VALVE)
+      lastValvePC = NominalRadValve.get();
+#endif
+#if defined(ENABLE_LOCAL_TRV)
+      lastTargetC = NominalRadValve.targetTemperatureSubSensor.get();
+#endif
+      }
+  };
+static StatsTXPolicy statsTXPolicy;
+#endif // defined(ENABLE_ADAPTIVE_STATS_TX)
+#if defined(ENABLE_PREPARED_STATS_TX) && defined(ENABLE_STATS_TX) && defined(ENABLE_OTSECUREFRAME_ENCODING_SUPPORT)
+#define _PREPARED_STATS_TX_ // Only secure frames are prepared ahead.
+// Secure stats frame built by bareStatsTX(..., true) ahead of its TX slot, ready to queue as is.
+static struct PreparedStatsTX
+  {
+  uint8_t len; // Frame length, 0 if none ready.
+  uint8_t minute, tlsd; // minuteCount and TIME_LSD when built, for the freshness check.
+  uint8_t frame[WorkspacePlan::STATS_MSG_BUF_SIZE];
+  } preparedStatsTX;
+#endif // defined(ENABLE_PREPARED_STATS_TX) && ...
+#if defined(ENABLE_OTSECUREFRAME_ENCODING_SUPPORT) && (defined(ENABLE_STATS_TX) || defined(ENABLE_FAST_CALL_FOR_HEAT_TX))
+// Encrypt a secure valve frame with the primary building key.
+// Shared by bareStatsTX() and bareCallForHeatTX().
+//   * sW  caller's workspace; crypto scratch is taken from beyond its first scratchUsed bytes
+//   * ptextBuf  WorkspacePlan::SECURE_PTEXT_LEN bytes of plaintext, body from ptextBuf[2]
+//   * out, outSize  the frame is written from out[0], its leading length byte
+//   * reportNoKey  print why on Serial (which must be running) if there is no key
+// Returns the frame length including the leading length byte, 0 on failure.
+static uint8_t encodeSecureValveFrame(OTV0P2BASE::ScratchSpaceL &sW, const uint8_t scratchUsed,
+                                      uint8_t *const ptextBuf,
+                                      uint8_t *const out, const uint8_t outSize,
+                                      const uint8_t valvePC, const bool reportNoKey)
+  {
+  // Get the 'building' key.
+  uint8_t key[16];
+  if(!OTV0P2BASE::getPrimaryBuilding16ByteSecretKey(key))
+    {
+    if(reportNoKey) { OTV0P2BASE::serialPrintlnAndFlush(F("!TX key")); } // Know why TX failed.
+    return(0);
+    }
+  // Explicit-workspace version of encryption.
+  OTRadioLink::SimpleSecureFrame32or0BodyTXBase::fixed32BTextSize12BNonce16BTagSimpleEnc_fn_t &eW = AESGCM_ENC_WITH_LWORKSPACE;
+  // Create subscratch space for encryption functions
+  OTV0P2BASE::ScratchSpaceL subScratch(sW, scratchUsed);
+  // Struct to pass data into encode function.
+  OTRadioLink::OTEncodeData_T fd(ptextBuf, WorkspacePlan::SECURE_PTEXT_LEN, out, outSize);
+  uint8_t bodylen;
+    {
+    CPU_BOOST();
+    bodylen = OTRadioLink::SimpleSecureFrame32or0BodyTXV0p2::getInstance().encodeValveFrame(
+        fd,
+        OTRadioLink::ENC_BODY_DEFAULT_ID_BYTES,
+        valvePC,
+        eW,
+        subScratch,
+        key);
+    }
+  // Do not leave the key lying about on the stack.
+  for(volatile uint8_t *k = key; k < key + sizeof(key); ++k) { *k = 0; }
+  return(bodylen);
+  }
+#endif // defined(ENABLE_OTSECUREFRAME_ENCODING_SUPPORT) && ...
 // Do bare stats transmission.
 // Output should be filtered for items appropriate
 // to current channel security and sensitivity level.
@@ -153,8 +331,11 @@ static OTV0P2BASE::SimpleStatsRotation<12> ss1; // Configured for maximum differ
 // Sends stats on primary radio channel 0 with possible duplicate to secondary channel.
 // If sending encrypted then ID/counter fields (eg @ and + for JSON) are omitted
 // as assumed supplied by security layer to remote recipent.
-void bareStatsTX(const bool allowDoubleTX, const bool doBinary)
+// Returns true if a frame was queued for TX (or prepared, with prepareOnly).
+bool bareStatsTX(const bool allowDoubleTX, const bool doBinary, const bool prepareOnly)
   {
+  LOOP_PROFILE_TASK(TASK_STATS_TX);
+
   // Capture heavy stack usage from local allocations here.
   OTV0P2BASE::MemoryChecks::recordIfMinSP(2);
 
@@ -167,6 +348,13 @@ void bareStatsTX(const bool allowDoubleTX, const bool doBinary)
   constexpr bool RFM23BFramed = false; // Never use this raw framing unless enabled explicitly.
 #endif
 
+#if defined(_PREPARED_STATS_TX_)
+  // Raw FF-terminated frames are built in place for TX, so leave them to the slot.
+  if(prepareOnly && RFM23BFramed) { return(false); }
+#else
+  (void) prepareOnly;
+#endif
+
 #if defined(ENABLE_OTSECUREFRAME_ENCODING_SUPPORT)
   constexpr bool doEnc = true;
 #else
@@ -178,16 +366,16 @@ void bareStatsTX(const bool allowDoubleTX, const bool doBinary)
 static_assert(OTV0P2BASE::FullStatsMessageCore_MAX_BYTES_ON_WIRE <= STATS_MSG_MAX_LEN, "FullStatsMessageCore_MAX_BYTES_ON_WIRE too big");
 static_assert(OTV0P2BASE::MSG_JSON_MAX_LENGTH+1 <= STATS_MSG_MAX_LEN, "MSG_JSON_MAX_LENGTH too big"); // Allow 1 for trailing CRC.
 
-    // Create scratch space for secure stats TX // FIXME
+    // Scratch space for secure stats TX, from the shared workspace (see WorkspacePlan).
     // Buffer need be no larger than leading length byte + typical 64-byte radio module TX buffer limit + optional terminator.
-    constexpr uint8_t MSG_BUF_SIZE = 1 + 64 + 1;
-    constexpr uint8_t bufEncJSONlen = OTRadioLink::ENC_BODY_SMALL_FIXED_PTEXT_MAX_SIZE + 1;  // 3 = '}' + 0x0 + ? FIXME whuut?
-    constexpr uint8_t ptextBuflen = bufEncJSONlen + 2;  // 2 = valvePC + hasStats
-    static_assert(ptextBuflen == 34, "ptextBuflen wrong");  // TODO make sure this is correct!
-    constexpr uint8_t scratchSpaceNeeded = MSG_BUF_SIZE + ptextBuflen;
-    constexpr size_t WorkspaceSize = OTRadioLink::SimpleSecureFrame32or0BodyTXBase::encodeValveFrame_total_scratch_usage_OTAESGCM_2p0 + scratchSpaceNeeded;
-    uint8_t workspace[WorkspaceSize];
-    OTV0P2BASE::ScratchSpaceL sW(workspace, sizeof(workspace));
+    constexpr uint8_t MSG_BUF_SIZE = WorkspacePlan::STATS_MSG_BUF_SIZE;
+    constexpr uint8_t bufEncJSONlen = WorkspacePlan::STATS_ENC_JSON_LEN; // Largest secure JSON + null + over-length check byte.
+    // The plaintext and crypto scratch are only needed when encrypting;
+    // plain JSON is written straight into the TX frame in the message buffer.
+    constexpr uint8_t scratchSpaceNeeded = WorkspacePlan::STATS_SCRATCH_NEEDED;
+    static_assert(doEnc == WorkspacePlan::doEnc, "workspace plan out of step");
+    WORKSPACE_CLAIM(WS_STATS_TX);
+    OTV0P2BASE::ScratchSpaceL sW(workspaceFor<WS_STATS_TX>(), WorkspacePlan::size(WS_STATS_TX));
 
   // Allow space in buffer for:
   //   * buffer offset/preamble
@@ -195,6 +383,9 @@ static_assert(OTV0P2BASE::MSG_JSON_MAX_LENGTH+1 <= STATS_MSG_MAX_LEN, "MSG_JSON_
   //   * terminating 0xff
   uint8_t * const buf = sW.buf;
 
+  // Set once a frame has been queued (or prepared).
+  bool done = false;
+
 #if defined(ENABLE_JSON_OUTPUT)
   if(doBinary && !doEnc) // Note that binary form is not secure, so not permitted for secure systems.
 #endif // ENABLE_JSON_OUTPUT
@@ -209,16 +400,17 @@ static_assert(OTV0P2BASE::MSG_JSON_MAX_LENGTH+1 <= STATS_MSG_MAX_LEN, "MSG_JSON_
                     Supply_cV.isSupplyVoltageLow(),
                     AmbLight.get(),
                     Occupancy.twoBitOccupancyValue());
-    const uint8_t *msg1 = OTV0P2BASE::encodeFullStatsMessageCore(buf + STATS_MSG_START_OFFSET, sW.bufsize - STATS_MSG_START_OFFSET, OTV0P2BASE::getStatsTXLevel(), false, &content);
+    const uint8_t *msg1 = OTV0P2BASE::encodeFullStatsMessageCore(buf + STATS_MSG_START_OFFSET, sW.bufsize - STATS_MSG_START_OFFSET, getStatsTXLevelFast(), false, &content);
     if(NULL == msg1)
       {
 #if 0
 DEBUG_SERIAL_PRINTLN_FLASHSTRING("Bin gen err!");
 #endif
-      return;
+      return(false);
       }
     // Send it!
     RFM22RawStatsTXFFTerminated(buf, allowDoubleTX);
+    done = true;
     // Record stats as if remote, and treat channel as secure.
     outputCoreStats(&Serial, true, &content);
 #endif // defined(ENABLE_BINARY_STATS_TX) ...
@@ -325,17 +517,23 @@ DEBUG_SERIAL_PRINTLN_FLASHSTRING("Bin gen err!");
     // Show state of setback lockout.
     ss1.put(V0p2_SENSOR_TAG_F("gE"), OTRadValve::getSetbackLockout(), true);
 #endif // ENABLE_SETBACK_LOCKOUT_COUNTDOWN
+#if defined(ENABLE_RX_QUEUE_STATS)
+    // RX queue health: frames dropped for lack of queue space, frames filtered out (both wrapping counts)
+    // and the most frames seen queued at once since last reported.
+    ss1.put(V0p2_SENSOR_TAG_F("RXd"), PrimaryRadio.getRXMsgsDroppedRecent(), true);
+    ss1.put(V0p2_SENSOR_TAG_F("RXf"), PrimaryRadio.getRXMsgsFilteredRecent(), true);
+    ss1.put(V0p2_SENSOR_TAG_F("RXh"), rxQueueHighWater, true);
+    rxQueueHighWater = 0;
+#endif // defined(ENABLE_RX_QUEUE_STATS)
 #if defined(ENABLE_ALWAYS_TX_ALL_STATS)
     const uint8_t privacyLevel = OTV0P2BASE::stTXalwaysAll;
 #else
-    const uint8_t privacyLevel = OTV0P2BASE::getStatsTXLevel();
+    const uint8_t privacyLevel = getStatsTXLevelFast();
 #endif
 
     // Redirect JSON output appropriately.
     // Part of sW, directly after the message buffer.
-    // |    0    |     1    | 2 |  3:n | n+1 | n+2 | n is the end of the stats message. n+2 <= 34
-    // | valvePC | hasStats | { | json | '}' | 0x0 |
-    // ptextBuf is the entire frame
+    // ptextBuf is the entire frame plaintext (see WorkspacePlan::SECURE_PTEXT_LEN).
     uint8_t * const ptextBuf = sW.buf + MSG_BUF_SIZE;
 
     // Allow for a cap on JSON TX size, eg where TX is lossy for near-maximum sizes.
@@ -358,6 +556,7 @@ DEBUG_SERIAL_PRINTLN_FLASHSTRING("Bin gen err!");
     // Generate JSON text.
     if(!sendingJSONFailed)
       {
+      CPU_BOOST();
       // Generate JSON and write to appropriate buffer:
       // direct to TX buffer if not encrypting, else to separate buffer.
       wrote = ss1.writeJSON(bufJSON, bufJSONlen, privacyLevel, maximise); //!allowDoubleTX && randRNG8NextBoolean());
@@ -373,12 +572,13 @@ DEBUG_SERIAL_PRINTLN_FLASHSTRING("JSON gen err!");
     // Push the JSON output to Serial.
     if(!sendingJSONFailed)
       {
+      ENERGY_CHARGE_TICKS(E_SERIAL, ENERGY_UC_SERIAL_TICK);
  #if defined(ENABLE_OTSECUREFRAME_ENCODING_SUPPORT)
       if(doEnc)
         {
         // Insert synthetic full ID/@ field for local stats, but no sequence number for now.
         Serial.print(F("{\"@\":\""));
-        for(int i = 0; i < OTV0P2BASE::OpenTRV_Node_ID_Bytes; ++i) { Serial.print(eeprom_read_byte((uint8_t *)V0P2BASE_EE_START_ID+i), HEX); }
+        for(int i = 0; i < OTV0P2BASE::OpenTRV_Node_ID_Bytes; ++i) { Serial.print(getNodeIDByteFast(i), HEX); }
         Serial.print(F("\","));
         Serial.write(bufJSON+1, wrote-1);
         Serial.println();
@@ -389,33 +589,12 @@ DEBUG_SERIAL_PRINTLN_FLASHSTRING("JSON gen err!");
       OTV0P2BASE::flushSerialSCTSensitive(); // Ensure all flushed since system clock may be messed with...
       }
 
-    // Get the 'building' key for stats sending.
-    uint8_t key[16];
-    if(!sendingJSONFailed && doEnc)
-      {
-#if defined(ENABLE_OTSECUREFRAME_ENCODING_SUPPORT)
-      if(!OTV0P2BASE::getPrimaryBuilding16ByteSecretKey(key))
-        {
-        sendingJSONFailed = true;
-        OTV0P2BASE::serialPrintlnAndFlush(F("!TX key")); // Know why TX failed.
-        }
-#else
-      sendingJSONFailed = true; // Crypto support may not be available.
-#endif // defined(ENABLE_OTSECUREFRAME_ENCODING_SUPPORT)
-      }
-
     // If doing encryption
     // then build encrypted frame from raw JSON.
     if(!sendingJSONFailed && doEnc)
       {
 #if defined(ENABLE_OTSECUREFRAME_ENCODING_SUPPORT)
       // TODO Fold JSON
-      // Explicit-workspace version of encryption.
-      OTRadioLink::SimpleSecureFrame32or0BodyTXBase::fixed32BTextSize12BNonce16BTagSimpleEnc_fn_t &eW = OTAESGCM::fixed32BTextSize12BNonce16BTagSimpleEnc_DEFAULT_WITH_LWORKSPACE;
-
-      // Create subscratch space for encryption functions
-      OTV0P2BASE::ScratchSpaceL subScratch(sW, scratchSpaceNeeded);
-      constexpr uint8_t txIDLen = OTRadioLink::ENC_BODY_DEFAULT_ID_BYTES;
       // When sending on a channel with framing, do not explicitly send the frame length byte.
       const uint8_t offset = framed ? 1 : 0;
       // Assumed to be at least one free writeable byte ahead of bptr.
@@ -426,19 +605,10 @@ DEBUG_SERIAL_PRINTLN_FLASHSTRING("JSON gen err!");
       // Distinguished 'invalid' valve position; never mistaken for a real valve.
       constexpr uint8_t valvePC = 0x7f;
 #endif // defined(ENABLE_NOMINAL_RAD_VALVE)
-      // Struct to pass data into encode function.
-      OTRadioLink::OTEncodeData_T fd(
-          ptextBuf,
-          ptextBuflen,
+      const uint8_t bodylen = encodeSecureValveFrame(sW, scratchSpaceNeeded, ptextBuf,
           (realTXFrameStart - offset),
-          (MSG_BUF_SIZE - (realTXFrameStart-buf) + offset));
-      const uint8_t bodylen = OTRadioLink::SimpleSecureFrame32or0BodyTXV0p2::getInstance().encodeValveFrame(
-            fd,
-            txIDLen,
-            valvePC,
-            eW,
-            subScratch,
-            key);
+          (MSG_BUF_SIZE - (realTXFrameStart-buf) + offset),
+          valvePC, true);
       sendingJSONFailed = (0 == bodylen);
       wrote = bodylen - offset;
 #else  // defined(ENABLE_OTSECUREFRAME_ENCODING_SUPPORT)
@@ -451,7 +621,7 @@ DEBUG_SERIAL_PRINTLN_FLASHSTRING("JSON gen err!");
 #endif
 
 #ifdef ENABLE_RADIO_SECONDARY_MODULE
-    if(!sendingJSONFailed)
+    if(!sendingJSONFailed && !prepareOnly)
       {
       // Write out unadjusted JSON or encrypted frame on secondary radio.
 //      SecondaryRadio.queueToSend(realTXFrameStart, doEnc ? (bptr - realTXFrameStart) : wrote);
@@ -476,6 +646,15 @@ DEBUG_SERIAL_PRINTLN_FLASHSTRING("JSON gen err!");
             }
           }
 
+#if defined(_PREPARED_STATS_TX_)
+      // Keep the finished frame for its TX slot (see sendPreparedStatsTX()).
+      if(prepareOnly)
+        {
+        memcpy(preparedStatsTX.frame, realTXFrameStart, wrote);
+        preparedStatsTX.len = wrote;
+        }
+      else
+#endif
 #if defined(ENABLE_RFM23B_FS20_RAW_PREAMBLE)
       // Use ugly 0xff-terminated RFM23B send.
       if(RFM23BFramed)
@@ -487,6 +666,7 @@ DEBUG_SERIAL_PRINTLN_FLASHSTRING("JSON gen err!");
 #endif
         {
         // Send directly to the primary radio...
+        ENERGY_CHARGE_TX(wrote, false);
         if(!PrimaryRadio.queueToSend(realTXFrameStart, wrote)) { sendingJSONFailed = true; }
         }
       }
@@ -494,14 +674,42 @@ DEBUG_SERIAL_PRINTLN_FLASHSTRING("JSON gen err!");
 #if 1 && defined(DEBUG)
     if(sendingJSONFailed) { DEBUG_SERIAL_PRINTLN_FLASHSTRING("!failed JSON TX"); }
 #endif
+    done = !sendingJSONFailed;
     }
 #endif // defined(ENABLE_JSON_OUTPUT)
 
 //DEBUG_SERIAL_PRINTLN_FLASHSTRING("Stats TX");
   if(neededWaking) { OTV0P2BASE::flushSerialProductive(); OTV0P2BASE::powerDownSerial(); }
+  return(done);
   }
 #endif // defined(ENABLE_STATS_TX)
 
+#if defined(ENABLE_FAST_CALL_FOR_HEAT_TX) && defined(ENABLE_OTSECUREFRAME_ENCODING_SUPPORT) && defined(ENABLE_NOMINAL_RAD_VALVE)
+// Set when the call for heat has changed and not yet been sent.
+static bool callForHeatTXPending;
+// Send a short secure valve-only frame (no stats body) straight away
+// so that a hub sees a change in call for heat without waiting for the next stats slot.
+// Framed channels only; returns false if nothing was queued.
+static bool bareCallForHeatTX()
+  {
+  if(PrimaryRadio.getChannelConfig()->isUnframed) { return(false); }
+  // Leading length byte + typical 64-byte radio module TX buffer limit.
+  constexpr uint8_t MSG_BUF_SIZE = WorkspacePlan::CFH_MSG_BUF_SIZE;
+  constexpr uint8_t scratchSpaceNeeded = WorkspacePlan::CFH_SCRATCH_NEEDED;
+  WORKSPACE_CLAIM(WS_CALL_FOR_HEAT_TX);
+  OTV0P2BASE::ScratchSpaceL sW(workspaceFor<WS_CALL_FOR_HEAT_TX>(), WorkspacePlan::size(WS_CALL_FOR_HEAT_TX));
+  uint8_t *const buf = sW.buf;
+  // Plaintext as for bareStatsTX(), with no stats after the first two bytes.
+  uint8_t *const ptextBuf = buf + MSG_BUF_SIZE;
+  ptextBuf[2] = '\0'; // No stats.
+  const uint8_t bodylen = encodeSecureValveFrame(sW, scratchSpaceNeeded, ptextBuf, buf, MSG_BUF_SIZE, NominalRadValve.get(), false);
+  if(bodylen < 2) { return(false); }
+  // Channel is framed so do not send the leading length byte.
+  ENERGY_CHARGE_TX(bodylen - 1, false);
+  return(PrimaryRadio.queueToSend(buf + 1, bodylen - 1));
+  }
+#endif // defined(ENABLE_FAST_CALL_FOR_HEAT_TX) && defined(ENABLE_OTSECUREFRAME_ENCODING_SUPPORT) && defined(ENABLE_NOMINAL_RAD_VALVE)
+
 
 // Wire components together, eg for occupancy sensing.
 static void wireComponentsTogether()
@@ -580,6 +788,223 @@ static constexpr uint_fast8_t TIME_CYCLE_S = 60;
 // Controller's notion/cache of seconds within major cycle.
 static uint_fast8_t TIME_LSD;
 
+#if defined(ENABLE_LOOP_PROFILER)
+// Singleton loop profiler.
+LoopProfiler loopProfiler;
+
+void LoopProfiler::reset()
+  {
+  for(Stat &s : slots) { s.min = 0xff; s.max = 0; s.meanX16 = 0; }
+  for(Stat &s : tasks) { s.min = 0xff; s.max = 0; s.meanX16 = 0; }
+  for(Late &l : late) { l.tlsd = 0xff; l.endSCT = 0; }
+  lateNext = 0;
+  }
+
+// Track min and max, and mean as an exponentially-smoothed value (1/8 weight) in 1/16ths of a tick.
+void LoopProfiler::update(Stat &s, const uint8_t ticks)
+  {
+  const uint16_t x16 = ((uint16_t)ticks) << 4;
+  if(s.min > s.max) { s.meanX16 = x16; } // First sample.
+  else { s.meanX16 = (uint16_t)(s.meanX16 + (((int16_t)(x16 - s.meanX16)) >> 3)); }
+  if(ticks < s.min) { s.min = ticks; }
+  if(ticks > s.max) { s.max = ticks; }
+  }
+
+void LoopProfiler::recordLoopEnd(const uint_fast8_t tlsd, const uint8_t endSCT, const bool overrun)
+  {
+  if(!overrun && (endSCT < LATE_SCT)) { return; }
+  late[lateNext].tlsd = (uint8_t)tlsd;
+  late[lateNext].endSCT = overrun ? OVERRUN_SCT : endSCT;
+  lateNext = (lateNext + 1) % LATE_RING_SIZE;
+  }
+
+// Print " min max mean" for a non-empty stat.
+void LoopProfiler::print(Print &p, const Stat &s)
+  {
+  p.print(' '); p.print(s.min);
+  p.print(' '); p.print(s.max);
+  p.print(' '); p.print((s.meanX16 + 8) >> 4);
+  }
+
+// Prints one line per non-empty slot ("@TLSD min max mean")
+// and task ("#TASK min max mean") in sub-cycle ticks,
+// then recent late loops oldest first as "!TLSD/endSCT", endSCT 255 for overrun.
+void LoopProfiler::dump(Print &p, const uint8_t stopBy) const
+  {
+  for(uint8_t i = 0; i < SLOTS; ++i)
+    {
+    if(slots[i].min > slots[i].max) { continue; }
+    if(OTV0P2BASE::getSubCycleTime() >= stopBy) { p.println(F("...")); return; }
+    p.print('@'); p.print(i << 1); print(p, slots[i]); p.println();
+    }
+  for(uint8_t i = 0; i < TASK_COUNT; ++i)
+    {
+    if(tasks[i].min > tasks[i].max) { continue; }
+    p.print('#'); p.print(i); print(p, tasks[i]); p.println();
+    }
+  for(uint8_t i = 0; i < LATE_RING_SIZE; ++i)
+    {
+    const Late &l = late[(lateNext + i) % LATE_RING_SIZE];
+    if(0xff == l.tlsd) { continue; }
+    p.print('!'); p.print(l.tlsd); p.print('/'); p.print(l.endSCT); p.print(' ');
+    }
+  p.println();
+  }
+#endif // defined(ENABLE_LOOP_PROFILER)
+
+#if defined(ENABLE_ENERGY_LEDGER)
+// Singleton energy ledger.
+EnergyLedger energyLedger;
+
+void EnergyLedger::reset()
+  {
+  for(uint8_t i = 0; i < E_COUNT; ++i) { thisHourUC[i] = 0; lastHourUAh[i] = 0; totalUAh[i] = 0; }
+  for(uint16_t &h : byHourUAh) { h = 0xffff; }
+  }
+
+void EnergyLedger::endOfHour(const uint8_t hour)
+  {
+  uint32_t hourUAh = 0;
+  for(uint8_t i = 0; i < E_COUNT; ++i)
+    {
+    const uint32_t uAh = (thisHourUC[i] + 1800) / 3600;
+    thisHourUC[i] = 0;
+    lastHourUAh[i] = (uint16_t)OTV0P2BASE::fnmin(uAh, (uint32_t)0xfffe);
+    totalUAh[i] += uAh;
+    hourUAh += uAh;
+    }
+  byHourUAh[hour % 24] = (uint16_t)OTV0P2BASE::fnmin(hourUAh, (uint32_t)0xfffe);
+  }
+
+// Prints in uAh, in EnergyLedger::subsystem_t order:
+// "=B" and the last complete hour by subsystem,
+// "=b" and the total since reset by subsystem,
+// "=h" and all subsystems by hour of day 0--23 ('-' if unknown).
+void EnergyLedger::dump(Print &p, const uint8_t stopBy) const
+  {
+  p.print(F("=B"));
+  for(uint8_t i = 0; i < E_COUNT; ++i) { p.print(' '); p.print(lastHourUAh[i]); }
+  p.println();
+  p.print(F("=b"));
+  for(uint8_t i = 0; i < E_COUNT; ++i) { p.print(' '); p.print(totalUAh[i]); }
+  p.println();
+  OTV0P2BASE::flushSerialProductive();
+  if(OTV0P2BASE::getSubCycleTime() >= stopBy) { return; }
+  p.print(F("=h"));
+  for(uint8_t h = 0; h < 24; ++h)
+    {
+    p.print(' ');
+    if(0xffff == byHourUAh[h]) { p.print('-'); } else { p.print(byHourUAh[h]); }
+    }
+  p.println();
+  }
+#endif // defined(ENABLE_ENERGY_LEDGER)
+
+#if defined(ENABLE_CPU_BOOST)
+CPUBoost::CPUBoost() : saved(clock_prescale_get()), factor(1), savedUBRR(0)
+  {
+  if(clock_div_8 != saved) { return; } // Already boosted (or otherwise non-standard).
+  const bool full = (Supply_cV.get() >= CPU_BOOST_8MHZ_MIN_CV);
+  factor = full ? 8 : 4;
+  // No UART bits in flight across the change.
+  OTV0P2BASE::flushSerialSCTSensitive();
+#if defined(UBRR0)
+  savedUBRR = UBRR0;
+  UBRR0 = (uint16_t)((savedUBRR + 1) * factor - 1);
+#endif
+  clock_prescale_set(full ? clock_div_1 : clock_div_2);
+#if defined(ENABLE_ENERGY_LEDGER)
+  startSCT = OTV0P2BASE::getSubCycleTime();
+#endif
+  }
+
+CPUBoost::~CPUBoost()
+  {
+  if(1 == factor) { return; }
+  OTV0P2BASE::flushSerialSCTSensitive();
+  clock_prescale_set(saved);
+#if defined(UBRR0)
+  UBRR0 = savedUBRR;
+#endif
+#if defined(ENABLE_ENERGY_LEDGER)
+  // The end-of-cycle E_CPU charge assumes 1MHz throughout, so add the difference.
+  const uint8_t end = OTV0P2BASE::getSubCycleTime();
+  const uint8_t ucTick = (8 == factor) ? CPU_BOOST_UC_TICK_8MHZ : CPU_BOOST_UC_TICK_4MHZ;
+  if(end > startSCT) { ENERGY_CHARGE(E_CPU, (uint32_t)(ucTick - CPU_BOOST_UC_TICK_1MHZ) * (end - startSCT)); }
+#endif
+  }
+
+#if defined(ENABLE_OTSECUREFRAME_ENCODING_SUPPORT)
+// Sub-cycle ticks for a fixed batch of 32-byte secure frame encryptions.
+static uint8_t timeEncryptions(OTV0P2BASE::ScratchSpaceL &sW)
+  {
+  static constexpr uint8_t RUNS = 8;
+  uint8_t key[16] = { }, iv[12] = { }, text[32] = { }, tag[16];
+  const uint8_t start = OTV0P2BASE::getSubCycleTime();
+  for(uint8_t i = 0; i < RUNS; ++i)
+    {
+    iv[11] = i;
+    AESGCM_ENC_WITH_LWORKSPACE(sW, key, iv, iv, sizeof(iv), text, text, tag);
+    }
+  return((uint8_t)(OTV0P2BASE::getSubCycleTime() - start));
+  }
+
+// Prints "=Y t1 tB xF uC1 uCB":
+// ticks for the batch at 1MHz and boosted, the boost factor,
+// and the nominal CPU charge for each.
+void benchmarkCPUBoost(Print &p)
+  {
+  WORKSPACE_CLAIM(WS_CPU_BENCH);
+  OTV0P2BASE::ScratchSpaceL sW(workspaceFor<WS_CPU_BENCH>(), WorkspacePlan::size(WS_CPU_BENCH));
+  const uint8_t t1 = timeEncryptions(sW);
+  uint8_t tB, f;
+    {
+    const CPUBoost b;
+    f = b.getFactor();
+    tB = timeEncryptions(sW);
+    }
+  const uint8_t ucTickB = (8 == f) ? CPU_BOOST_UC_TICK_8MHZ : ((4 == f) ? CPU_BOOST_UC_TICK_4MHZ : CPU_BOOST_UC_TICK_1MHZ);
+  p.print(F("=Y ")); p.print(t1);
+  p.print(' '); p.print(tB);
+  p.print(F(" x")); p.print(f);
+  p.print(' '); p.print((uint16_t)t1 * CPU_BOOST_UC_TICK_1MHZ);
+  p.print(' '); p.print((uint16_t)tB * ucTickB);
+  p.println();
+  }
+#endif // defined(ENABLE_OTSECUREFRAME_ENCODING_SUPPORT)
+#endif // defined(ENABLE_CPU_BOOST)
+
+#if defined(ENABLE_CACHED_AESGCM_CONTEXT) && defined(ENABLE_OTSECUREFRAME_ENCODING_SUPPORT)
+AES128GCMContext<(0 != AESGCM_CONTEXT_GHASH_TABLE)> aesgcmContext;
+
+// Text is fixed at 32 bytes, or none if plaintext/ciphertext is NULL.
+bool fixed32BTextSize12BNonce16BTagSimpleEnc_CACHED(OTV0P2BASE::ScratchSpaceL &,
+        const uint8_t *const key, const uint8_t *const iv,
+        const uint8_t *const authtext, const uint8_t authtextSize,
+        const uint8_t *const plaintext,
+        uint8_t *const ciphertextOut, uint8_t *const tagOut)
+  {
+  if((NULL == key) || (NULL == iv) || (NULL == tagOut) || ((NULL != plaintext) && (NULL == ciphertextOut))) { return(false); }
+  aesgcmContext.setKey(key);
+  aesgcmContext.encrypt(iv, authtext, authtextSize, plaintext, (NULL == plaintext) ? 0 : 32, ciphertextOut, tagOut);
+  return(true);
+  }
+#endif // defined(ENABLE_CACHED_AESGCM_CONTEXT) && defined(ENABLE_OTSECUREFRAME_ENCODING_SUPPORT)
+
+#if defined(ENABLE_CONFIG_CACHE)
+// Singleton RAM shadow of hot EEPROM config.
+ConfigCache configCache;
+
+void ConfigCache::reload()
+  {
+  statsTXLevel = OTV0P2BASE::getStatsTXLevel();
+  for(uint8_t i = 0; i < sizeof(nodeID); ++i) { nodeID[i] = eeprom_read_byte((uint8_t *)V0P2BASE_EE_START_ID + i); }
+#if defined(ENABLE_FHT8VSIMPLE)
+  fht8vHC = FHT8V.nvGetHC();
+#endif
+  }
+#endif // defined(ENABLE_CONFIG_CACHE)
+
 // 'Elapsed minutes' count of minute/major cycles; cheaper than accessing RTC and not tied to real time.
 // Starts at or just above zero (within the first 4-minute cycle) to help avoid collisions between units after mass power-up.
 // Wraps at its maximum (0xff) value.
@@ -730,6 +1155,11 @@ void setupOpenTRV()
   TIME_LSD = OTV0P2BASE::getSecondsLT();
   }
 
+#if defined(ENABLE_TICKLESS_IDLE)
+// Set by pin-change interrupts (buttons, serial RX, etc) to end a run of skipped minor cycles.
+static volatile bool tickWakeRequested;
+#endif
+
 #if !defined(ALT_MAIN_LOOP) // Do not define handlers here when alt main is in use.
 
 #if defined(MASK_PB) && (MASK_PB != 0) // If PB interrupts required.
@@ -779,6 +1209,11 @@ ISR(PCINT2_vect)
   const uint8_t changes = pins ^ prevStatePD;
   prevStatePD = pins;
 
+#if defined(ENABLE_TICKLESS_IDLE)
+  // Run the loop body at the next tick for any button/RX activity.
+  tickWakeRequested = true;
+#endif
+
 #if defined(ENABLE_SIMPLIFIED_MODE_BAKE)
   // Mode button detection is on the falling edge (button pressed).
   if((changes & MODE_INT_MASK) && !(pins & MODE_INT_MASK))
@@ -899,11 +1334,730 @@ static bool setUpContinuousRX()
 // Passing nullptr/nothing would be more satisfying solution, but due to other
 // macro flags, this is slightly less horrible.
 #if defined(ENABLE_RADIO_RX)
-bool preSleepFn() { return (messageQueue.handle(true, PrimaryRadio)); }
+bool preSleepFn() { LOOP_PROFILE_TASK(TASK_MSG_QUEUE); return (messageQueue.handle(true, PrimaryRadio)); }
 #else
 bool preSleepFn() { return false; }
 #endif // ENABLE_RADIO_RX
 
+// Deal with any pending I/O from the main loop body, timing it if profiling.
+#if defined(ENABLE_RX_CAPTURE)
+// Write captured RX records to Serial, one '%'-prefixed hex line each (see RXCapture.h),
+// stopping early if the minor cycle is getting on.
+static void streamRXCapture()
+  {
+  uint8_t rec[RXCAP_HEADER_BYTES + 64];
+  uint8_t len = rxCapture.get(rec, sizeof(rec));
+  if(0 == len) { return; }
+  const bool neededWaking = OTV0P2BASE::powerUpSerialIfDisabled<>();
+  ENERGY_CHARGE_TICKS(E_SERIAL, ENERGY_UC_SERIAL_TICK);
+  do
+    {
+    Serial.print(RXCAP_SERIAL_PREFIX);
+    for(uint8_t i = 0; i < len; ++i)
+      {
+      Serial.print("0123456789abcdef"[rec[i] >> 4]);
+      Serial.print("0123456789abcdef"[rec[i] & 0xf]);
+      }
+    Serial.println();
+    } while((OTV0P2BASE::getSubCycleTime() < (OTV0P2BASE::GSCT_MAX / 2)) && (0 != (len = rxCapture.get(rec, sizeof(rec)))));
+  OTV0P2BASE::flushSerialSCTSensitive();
+  if(neededWaking) { OTV0P2BASE::powerDownSerial(); }
+  }
+#endif // defined(ENABLE_RX_CAPTURE)
+
+static bool handleMessageQueue()
+  {
+  LOOP_PROFILE_TASK(TASK_MSG_QUEUE);
+#if defined(ENABLE_RX_QUEUE_STATS)
+  // The queue is at its fullest just before being serviced.
+  const uint8_t queued = PrimaryRadio.getRXMsgsQueued();
+  if(queued > rxQueueHighWater) { rxQueueHighWater = queued; }
+#endif
+#if defined(ENABLE_FAST_CALL_FOR_HEAT_TX) && defined(ENABLE_BOILER_HUB)
+  const bool wasOn = BoilerHub.isBoilerOn();
+  const bool handled = messageQueue.handle(true, PrimaryRadio);
+  // Turn the boiler on as soon as a call for heat is heard
+  // rather than at the start of the next minor cycle,
+  // letting the boiler logic drive its own output (not a new second so no timers are aged).
+  if(!wasOn && BoilerHub.isBoilerOn()) { BoilerHub.processCallsForHeat(false, hubManager.inHubMode()); }
+  return(handled);
+#else
+  return(messageQueue.handle(true, PrimaryRadio));
+#endif
+  }
+
+
+// PER-MINUTE SCHEDULE
+//
+// Each task registers the even TIME_LSD slots it runs in, every minute,
+// its declared worst-case time in sub-cycle ticks (~8ms) from the start of its slot
+// including any deliberate wait, and whether it may be skipped when conserving battery.
+// loopOpenTRV() dispatches through a flat table built from this at compile time
+// (one lookup instead of a chain of branches),
+// and static_asserts check that no slot has two tasks or a budget beyond SLOT_BUDGET_MAX_SCT,
+// ie what is left of the minor cycle after the declared PRE_SLOT_SCT allowance
+// for the wake-up, UI and FHT8V work that runs before the slot task.
+// Longer-period or phased work (eg stats TX every other minute) is gated inside the task.
+
+// Try if very near to end of cycle and thus causing an overrun.
+// Conversely, if not true, should have time to safely log outputs, etc.
+static constexpr uint8_t LOOP_NEAR_OVERRUN_SCT = OTV0P2BASE::GSCT_MAX - 8; // ~64ms/~32 serial TX chars of grace time...
+// Declared worst-case sub-cycle ticks from the start of the minor cycle to the slot task.
+#if defined(ENABLE_FHT8VSIMPLE)
+// FHT8V TX may run up to and just past half second #1 (~GSCT_MAX/4) before the slot.
+static constexpr uint8_t PRE_SLOT_SCT = OTV0P2BASE::GSCT_MAX/4 + 16;
+#else
+// Wake-up latency (can be >10ms) plus UI handling, which must take ~300ms or less.
+static constexpr uint8_t PRE_SLOT_SCT = 40;
+#endif
+// Largest budget that a slot task may declare.
+static constexpr uint8_t SLOT_BUDGET_MAX_SCT = LOOP_NEAR_OVERRUN_SCT - PRE_SLOT_SCT;
+
+// Per-cycle state computed by loopOpenTRV() for the slot tasks.
+struct SlotContext
+  {
+  // False to skip less-critical tasks when particularly conserving energy.
+  const bool runAll;
+  // Sensor readings and (stats transmissions) are nominally on a 4-minute cycle.
+  const uint8_t minuteFrom4;
+  // True if this is the minute after all sensors should have been sampled.
+  const bool minute1From4AfterSensors;
+  // Last-measured battery status.
+  const bool batteryLow;
+  // True if FHT8V TX is using extra slots this cycle.
+  const bool useExtraFHT8VTXSlots;
+  // Set to show status at the end of the loop.
+  bool &showStatus;
+  };
+typedef void slotTask_fn_t(SlotContext &ctx);
+
+// Slot task flags.
+static constexpr uint8_t SLOT_RUN_ALL_ONLY = 1; // Skipped when conserving battery (!runAll).
+static constexpr uint8_t SLOT_FILL = 2; // Runs in the slots of its range that have no other task.
+
+struct SlotTask
+  {
+  uint8_t first, last; // Even TIME_LSD range, inclusive.
+  uint8_t budgetSCT; // Declared worst-case sub-cycle ticks.
+  uint8_t flags;
+  slotTask_fn_t *fn;
+  };
+
+// Tasks that must be run every minute.
+static void slotMinuteTasks(SlotContext &)
+  {
+  ++minuteCount; // Note simple roll-over to 0 at max value.
+#if defined(ENABLE_STATS_TX) && defined(ENABLE_ADAPTIVE_STATS_TX)
+  statsTXPolicy.tickMinute();
+#endif
+  // Force to user's programmed schedule(s), if any, at the correct time.
+  Scheduler.applyUserSchedule(&valveMode, OTV0P2BASE::getMinutesSinceMidnightLT());
+  // Ensure that the RTC has been persisted promptly when necessary.
+  OTV0P2BASE::persistRTC();
+  // Run hourly tasks at the end of the hour.
+  if(59 == OTV0P2BASE::getMinutesLT())
+      {
+      endOfHourTasks();
+      if(23 == OTV0P2BASE::getHoursLT())
+          { endOfDayTasks(); }
+      }
+  }
+
+// Churn/reseed PRNG(s) a little to improve unpredictability in use: should be lightweight.
+static void slotSeedRNG(SlotContext &)
+  { OTV0P2BASE::seedRNG8(minuteCount ^ OTV0P2BASE::getCPUCycleCount() ^ (uint8_t)Supply_cV.get(), OTV0P2BASE::_getSubCycleTime() ^ AmbLight.get(), (uint8_t)TemperatureC16.get()); }
+
+// Force read of supply/battery voltage; measure and recompute status (etc) less often when already thought to be low, eg when conserving.
+static void slotSupply(SlotContext &) { Supply_cV.read(); ENERGY_CHARGE(E_ADC, ENERGY_UC_ADC_READ); }
+
+#if defined(ENABLE_STATS_TX)
+// Periodic transmission of stats if NOT driving a local valve (else stats can be piggybacked onto that).
+// Randomised somewhat between slots and also within the slot to help avoid collisions.
+static uint8_t txTick;
+static CoTask statsTXJob;
+// Sub-cycle time until which the started stats TX job waits, spreading transmissions.
+static uint8_t statsTXJitterSCT;
+// Generous allowance in sub-cycle ticks to build, encrypt and queue/send a stats frame.
+static constexpr uint8_t STATS_TX_SCT = 64;
+// True if stats should be sent in this minute's chosen slot.
+static bool statsTXWanted(const SlotContext &ctx)
+  {
+#if defined(ENABLE_ADAPTIVE_STATS_TX)
+  // Send only on material change or when a heartbeat is due.
+  if(StatsTXPolicy::NONE == statsTXPolicy.need()) { return(false); }
+#endif
+
+#if defined(ENABLE_FHT8VSIMPLE)
+  // Avoid transmit conflict with FS20; just drop the slot.
+  // We should possibly choose between this and piggybacking stats to avoid busting duty-cycle rules.
+  if(ctx.useExtraFHT8VTXSlots && localFHT8VTRVEnabled()) { return(false); }
+#endif
+
+#if !defined(ENABLE_FREQUENT_STATS_TX) && !defined(ENABLE_ADAPTIVE_STATS_TX) // If ENABLE_FREQUENT_STATS_TX then send every minute regardless.
+  // Stats TX in the minute (#1) after all sensors should have been polled
+  // (so that readings are fresh) and evenly between.
+  // Usually send one frame every 4 minutes, 2 if this is a valve.
+  // No extra stats TX for changed data to reduce information/activity leakage.
+  // Note that all O frames contain the current valve percentage,
+  // which implies that any extra stats TX also speeds response to call-for-heat changes.
+#ifdef ENABLE_NOMINAL_RAD_VALVE
+  // DHD20170113: was once every 4 minutes, but can make boiler response too slow.
+  if(0 == (ctx.minuteFrom4 & 1)) { return(false); }
+#else
+  if(!ctx.minute1From4AfterSensors) { return(false); }
+#endif
+#endif
+
+  // Abort if not allowed to send stats at all.
+  // FIXME: fix this to send bare calls for heat / valve % instead from valves for secure non-FHT8V comms.
+  return(enableTrailingStatsPayload());
+  }
+
+// Try for double TX for extra robustness unless:
+//   * battery is low
+//   * this node is a hub so needs to listen as much as possible
+// Any recently-changed stats value is a hint that a strong transmission might be a good idea.
+static bool statsTXAllowDoubleTX() { return(!Supply_cV.isSupplyVoltageLow() && !hubManager.inHubMode() && ss1.changedValue()); }
+
+#if defined(_PREPARED_STATS_TX_)
+// Max age in seconds of a prepared frame for it still to be sent, ie built in the previous minor cycle.
+static constexpr uint8_t STATS_TX_PREPARED_MAX_AGE_S = 2;
+// Builds the frame for the stats TX slot in spare time in the minor cycle before it.
+static CoTask statsTXPrepareJob;
+static bool jobStatsTXPrepare(CoTask &ct, uint8_t)
+  {
+  CO_BEGIN(ct);
+  preparedStatsTX.len = 0;
+  // If this cycle has too little time left then the TX slot builds its own.
+  if(OTV0P2BASE::getSubCycleTime() < (LOOP_NEAR_OVERRUN_SCT - STATS_TX_SCT))
+    {
+    bareStatsTX(statsTXAllowDoubleTX(), false, true);
+    preparedStatsTX.minute = minuteCount;
+    preparedStatsTX.tlsd = TIME_LSD;
+    }
+  CO_END(ct);
+  }
+// Queue the prepared frame if fresh enough; returns false if there is none
+// or it could not be queued, so one must be built.
+// A frame is used at most once.
+static bool sendPreparedStatsTX()
+  {
+  const uint8_t len = preparedStatsTX.len;
+  preparedStatsTX.len = 0;
+  if((0 == len) || (preparedStatsTX.minute != minuteCount) ||
+     ((uint8_t)(TIME_LSD - preparedStatsTX.tlsd) > STATS_TX_PREPARED_MAX_AGE_S))
+    { return(false); }
+  LOOP_PROFILE_TASK(TASK_STATS_TX);
+#ifdef ENABLE_RADIO_SECONDARY_MODULE
+  SecondaryRadio.queueToSend(preparedStatsTX.frame, len);
+#endif
+  ENERGY_CHARGE_TX(len, false);
+  return(PrimaryRadio.queueToSend(preparedStatsTX.frame, len));
+  }
+#endif // defined(_PREPARED_STATS_TX_)
+
+// Note that a stats frame has been queued.
+static inline void statsTXSent()
+  {
+#if defined(ENABLE_ADAPTIVE_STATS_TX)
+  // Only now does the receiver know the new values.
+  statsTXPolicy.sent();
+#endif
+  }
+
+static void slotStatsTXPick(SlotContext &ctx)
+  {
+  txTick = OTV0P2BASE::randRNG8() & 7; // Pick which of the 8 slots to use.
+#if defined(_PREPARED_STATS_TX_)
+  if((0 == txTick) && statsTXWanted(ctx)) { statsTXPrepareJob.start(); }
+#else
+  (void) ctx;
+#endif
+  }
+static void slotStatsTX(SlotContext &ctx)
+  {
+  // Only the slot where txTick is zero is used.
+  if(0 != txTick--)
+    {
+#if defined(_PREPARED_STATS_TX_)
+    // Build the frame ahead if the next slot is the one.
+    if((0 == txTick) && statsTXWanted(ctx)) { statsTXPrepareJob.start(); }
+#endif
+    return;
+    }
+  if(!statsTXWanted(ctx)) { return; }
+
+  // Sleep randomly up to ~25% of the minor cycle
+  // to spread transmissions and thus help avoid collisions.
+  // (Longer than 25%/0.5s could interfere with other ops such as FHT8V TXes.)
+  statsTXJitterSCT = 1 + (((OTV0P2BASE::GSCT_MAX >> 2) | 7) & OTV0P2BASE::randRNG8());
+  statsTXJob.start();
+  }
+
+// Stats TX job, started by slotStatsTX(): waits out the jitter then sends,
+// carrying over into the next minor cycle if too little of this one is left to build/encrypt/send safely.
+static bool jobStatsTX(CoTask &ct, uint8_t)
+  {
+  CO_BEGIN(ct);
+  while(OTV0P2BASE::getSubCycleTime() <= statsTXJitterSCT)
+    {
+    // Handle any pending I/O while waiting.
+    if(handleMessageQueue()) { continue; }
+    // Sleep as long as possible without overshooting (~7.8ms per sub-cycle tick);
+    // RX interrupts still end the nap early.
+    const uint8_t left = statsTXJitterSCT + 1 - OTV0P2BASE::getSubCycleTime();
+    OTV0P2BASE::nap((left >= 16) ? WDTO_120MS : (left >= 8) ? WDTO_60MS : (left >= 4) ? WDTO_30MS : WDTO_15MS, true);
+    }
+
+  // Send stats!
+#if defined(_PREPARED_STATS_TX_)
+  // Just queue the frame built before this slot, if still fresh.
+  if(sendPreparedStatsTX()) { statsTXSent(); }
+  else
+#endif
+    {
+    CO_YIELD_IF_LATE(ct, LOOP_NEAR_OVERRUN_SCT - STATS_TX_SCT);
+    // This doesn't generally/always need to send binary/both formats
+    // if this is controlling a local FHT8V on which the binary stats can be piggybacked.
+    // Ie, if doesn't have a local TRV then it must send binary some of the time.
+#if defined(ENABLE_BINARY_STATS_TX) && defined(ENABLE_FS20_ENCODING_SUPPORT)
+    const bool doBinary = !localFHT8VTRVEnabled() && OTV0P2BASE::randRNG8NextBoolean();
+#else
+    const bool doBinary = false;
+#endif
+    if(bareStatsTX(statsTXAllowDoubleTX(), doBinary)) { statsTXSent(); }
+    }
+  CO_END(ct);
+  }
+
+#if defined(ENABLE_ADAPTIVE_STATS_TX)
+// On urgent change such as call for heat, start the stats TX job at once with no jitter,
+// so that it runs straight after the slot task that made the change,
+// rather than waiting up to a minute for the next regular or idle slot.
+static void startUrgentStatsTX(const SlotContext &ctx)
+  {
+  if(statsTXJob.pending) { return; }
+  if(StatsTXPolicy::URGENT != statsTXPolicy.need()) { return; }
+  if(!statsTXWanted(ctx)) { return; }
+  statsTXJitterSCT = 0;
+  statsTXJob.start();
+  }
+#endif // defined(ENABLE_ADAPTIVE_STATS_TX)
+#endif // defined(ENABLE_STATS_TX)
+
+#if defined(ENABLE_SECURE_RADIO_BEACON)
+// Send a small secure radio beacon "I'm alive!" message regularly if configured.
+static void slotBeacon(SlotContext &)
+  {
+#if 1 && defined(DEBUG)
+  DEBUG_SERIAL_PRINT_FLASHSTRING("Beacon TX... ");
+#endif
+  // Get the 'building' key for broadcast.
+  uint8_t key[16];
+  if(!OTV0P2BASE::getPrimaryBuilding16ByteSecretKey(key))
+    {
+#if 1 && defined(DEBUG)
+    DEBUG_SERIAL_PRINTLN_FLASHSTRING("!failed (no key)");
+#endif
+    return;
+    }
+  const OTRadioLink::SimpleSecureFrame32or0BodyTXBase::fixed32BTextSize12BNonce16BTagSimpleEnc_ptr_t e = OTAESGCM::fixed32BTextSize12BNonce16BTagSimpleEnc_DEFAULT_STATELESS;
+  const uint8_t txIDLen = OTRadioLink::ENC_BODY_DEFAULT_ID_BYTES;
+  uint8_t buf[OTRadioLink::generateSecureBeaconMaxBufSize];
+  const uint8_t bodylen = OTRadioLink::generateSecureBeaconRawForTX(buf, sizeof(buf), txIDLen, e, NULL, key);
+  // ASSUME FRAMED CHANNEL 0 (but could check with config isUnframed flag).
+  // When sending on a channel with framing, do not explicitly send the frame length byte.
+  // DO NOT attempt to send if construction of the secure frame failed;
+  // doing so may reuse IVs and destroy the cipher security.
+  if(0 != bodylen) { ENERGY_CHARGE_TX(bodylen-1, false); }
+  const bool success = (0 != bodylen) && PrimaryRadio.sendRaw(buf+1, bodylen-1);
+#if 1 && defined(DEBUG)
+  DEBUG_SERIAL_PRINT(success);
+  DEBUG_SERIAL_PRINTLN();
+#endif
+  (void) success;
+  }
+#endif // defined(ENABLE_SECURE_RADIO_BEACON)
+
+// SENSOR READ AND STATS
+//
+// All external sensor reads should be in the second half of the minute (>32) if possible.
+// This is to have them as close to stats collection at the end of the minute as possible,
+// and to allow randomisation of the start-up cycle position in the first 32s to help avoid inter-unit collisions.
+// Also all sources of noise, self-heating, etc, may be turned off for the 'sensor read minute'
+// and thus will have diminished by this point.
+
+// Sensor acquisition window: all of the minute's sensor reads back to back in one slot,
+// with the ADC and (where used) TWI powered up once around them rather than by each read;
+// the sensors' own ...IfDisabled() power handling then leaves both alone.
+// ADC reads go first while the TWI sensors settle, then the ADC is powered down.
+// At a hub, sample temperature regularly as late as possible in the minute just before recomputing valve position.
+// Force a regular read to make stats such as rate-of-change simple and to minimise lag.
+// TODO: optimise to reduce power consumption when not calling for heat.
+// TODO: optimise to reduce self-heating jitter when in hub/listen/RX mode.
+#if !defined(ENABLE_PRIMARY_TEMP_SENSOR_DS18B20) || defined(HUMIDITY_SENSOR_SUPPORT)
+#define SENSORS_USE_TWI // SHT21 or TMP112.
+#endif
+#if defined(ENABLE_ASYNC_TEMP_SENSOR)
+// Start the room temperature conversion one slot ahead of slotSensors(),
+// so that it completes while asleep rather than while blocked in read().
+static void slotSensorsStart(SlotContext &)
+  {
+#if !defined(ENABLE_PRIMARY_TEMP_SENSOR_DS18B20)
+  const bool neededTWI = OTV0P2BASE::powerUpTWIIfDisabled();
+#endif
+  TemperatureC16.startRead();
+#if !defined(ENABLE_PRIMARY_TEMP_SENSOR_DS18B20)
+  if(neededTWI) { OTV0P2BASE::powerDownTWI(); }
+#endif
+  }
+#endif // defined(ENABLE_ASYNC_TEMP_SENSOR)
+static void slotSensors(SlotContext &ctx)
+  {
+  const bool neededADC = OTV0P2BASE::powerUpADCIfDisabled();
+#if defined(SENSORS_USE_TWI)
+  const bool neededTWI = OTV0P2BASE::powerUpTWIIfDisabled();
+#endif
+
+#ifdef ENABLE_VOICE_SENSOR
+  // Poll voice detection sensor at a fixed rate.
+  Voice.read();
+#endif
+#ifdef TEMP_POT_AVAILABLE
+  // Sample the user-selected WARM temperature target at a fixed rate.
+  // This allows the unit to stay reasonably responsive to adjusting the temperature dial.
+  TempPot.read();
+  ENERGY_CHARGE(E_ADC, ENERGY_UC_ADC_READ);
+#endif
+#if defined(ENABLE_AMBLIGHT_SENSOR)
+  // Poll ambient light level at a fixed rate.
+  // This allows the unit to respond consistently to (eg) switching lights on (eg TODO-388).
+  // Force all UI lights off before sampling ambient light level.
+  OTV0P2BASE::LED_HEATCALL_OFF();
+#if defined(LED_UI2_EXISTS) && defined(ENABLE_UI_LED_2_IF_AVAILABLE)
+  // Turn off second UI LED if available.
+  OTV0P2BASE::LED_UI2_OFF();
+#endif
+  AmbLight.read();
+  ENERGY_CHARGE(E_ADC, ENERGY_UC_ADC_READ);
+#endif
+  if(neededADC) { OTV0P2BASE::powerDownADC(); }
+
+#if defined(ENABLE_ASYNC_TEMP_SENSOR)
+  // Fall back to a blocking read if no conversion was started or it is not done, eg just after reset.
+  // Not for the DS18B20: at full precision that takes ~750ms, far beyond this slot's budget,
+  // so its previous value (at least the one from setup()) is kept until next minute,
+  // unless no sensor is present, when read() returns at once with the error value;
+  // collectRead() itself sets the error value after a few failures in a row.
+  if(!TemperatureC16.collectRead())
+    {
+#if !defined(ENABLE_PRIMARY_TEMP_SENSOR_SHT21) && defined(ENABLE_PRIMARY_TEMP_SENSOR_DS18B20)
+    if(0 == TemperatureC16.getSensorCount())
+#endif
+      { TemperatureC16.read(); }
+    }
+#else
+  TemperatureC16.read();
+#endif
+#if defined(ENABLE_PRIMARY_TEMP_SENSOR_SHT21)
+  ENERGY_CHARGE(E_SHT21, ENERGY_UC_SHT21_TEMP);
+#endif
+#ifdef HUMIDITY_SENSOR_SUPPORT
+  // Sample humidity, less often when conserving energy.
+  if(ctx.runAll) { RelHumidity.read(); ENERGY_CHARGE(E_SHT21, ENERGY_UC_SHT21_RH); }
+#else
+  (void) ctx;
+#endif
+#if defined(SENSORS_USE_TWI)
+  if(neededTWI) { OTV0P2BASE::powerDownTWI(); }
+#endif
+  }
+
+// Compute targets and heat demand based on environmental inputs and occupancy.
+// This should happen as soon after the latest readings as possible (temperature especially).
+static void slotRecompute(SlotContext &ctx)
+  {
+#if defined(OTV0P2BASE_ErrorReport_DEFINED)
+  // Age errors/warnings.
+  OTV0P2BASE::ErrorReporter.read();
+#endif
+
+#if defined(ENABLE_OCCUPANCY_SUPPORT)
+  // Update occupancy measures that partially use rolling stats.
+
+  // Update occupancy status (fresh for target recomputation) at a fixed rate.
+  Occupancy.read();
+#endif // defined(ENABLE_OCCUPANCY_SUPPORT)
+
+#ifdef ENABLE_NOMINAL_RAD_VALVE
+  // Recompute target, valve position and call for heat, etc.
+  // Should be called once per minute to work correctly.
+  NominalRadValve.read();
+#endif
+#if defined(ENABLE_FAST_CALL_FOR_HEAT_TX) && defined(ENABLE_OTSECUREFRAME_ENCODING_SUPPORT) && defined(ENABLE_NOMINAL_RAD_VALVE)
+  // Send any change in call for heat as soon as there is time.
+    {
+    static bool wasCallingForHeat;
+    const bool callingForHeat = NominalRadValve.isControlledValveReallyOpen();
+    if(callingForHeat != wasCallingForHeat) { wasCallingForHeat = callingForHeat; callForHeatTXPending = true; }
+    }
+#endif
+#if defined(ENABLE_STATS_TX) && defined(ENABLE_ADAPTIVE_STATS_TX)
+  // Call for heat and occupancy have just been recomputed.
+  startUrgentStatsTX(ctx);
+#if defined(ENABLE_FAST_CALL_FOR_HEAT_TX) && defined(ENABLE_OTSECUREFRAME_ENCODING_SUPPORT) && defined(ENABLE_NOMINAL_RAD_VALVE)
+  // The stats frame about to go carries the new valve position, so don't send a second frame for it.
+  if(statsTXJob.pending) { callForHeatTXPending = false; }
+#endif
+#endif
+
+#if defined(ENABLE_FHT8VSIMPLE) && defined(ENABLE_LOCAL_TRV) // Only regen when needed.
+  // If there was a change in target valve position,
+  // or periodically in the minute after all sensors should have been read,
+  // precompute some or all of any outgoing frame/stats/etc ready for the next transmission.
+  if(NominalRadValve.isValveMoved() ||
+     (ctx.minute1From4AfterSensors && enableTrailingStatsPayload()))
+    {
+    if(localFHT8VTRVEnabled()) { FHT8V.set(NominalRadValve.get() /*, NominalRadValve.isCallingForHeat() */); }
+    }
+
+#if defined(ENABLE_BOILER_HUB)
+  // Feed in the local valve position when calling for heat just as if over the air.
+  // (Does not arrive with the normal FHT8V timing of 2-minute gaps so boiler may turn off out of sync.)
+  if(FHT8V.isControlledValveReallyOpen())
+    {
+#if defined(ENABLE_CONFIG_CACHE)
+    const uint16_t hc = configCache.getFHT8VHC();
+#else
+    const uint16_t hc = FHT8V.nvGetHC();
+#endif
+    BoilerHub.remoteCallForHeatRX(hc, FHT8V.get(), minuteCount);
+    }
+#endif // defined(ENABLE_BOILER_HUB)
+#elif defined(ENABLE_NOMINAL_RAD_VALVE) && defined(ENABLE_LOCAL_TRV) // Other local valve types, simulate a remote call for heat with a fake ID.
+#if defined(ENABLE_BOILER_HUB)
+  // Feed in the local valve position when calling for heat just as if over the air.
+  if(NominalRadValve.isControlledValveReallyOpen()) { BoilerHub.remoteCallForHeatRX(~0, NominalRadValve.get(), minuteCount); }
+#endif // defined(ENABLE_BOILER_HUB)
+#endif
+
+#if 1 && defined(DEBUG) && defined(ENABLE_BOILER_HUB) && !defined(ENABLE_TRIMMED_MEMORY)
+  // Track how long since remote call for heat last heard.
+  if(BoilerHub.isBoilerOn())
+    {
+    DEBUG_SERIAL_PRINT_FLASHSTRING("Boiler on, s: ");
+    DEBUG_SERIAL_PRINT(boilerCountdownTicks * OTV0P2BASE::MAIN_TICK_S);
+    DEBUG_SERIAL_PRINTLN();
+    }
+#endif
+
+  // Show current status if appropriate.
+  if(ctx.runAll) { ctx.showStatus = true; }
+  }
+
+#if defined(ENABLE_STATS_TX) && defined(ENABLE_ADAPTIVE_STATS_TX)
+// In otherwise idle slots after the regular stats slots,
+// catch any urgent change made outside slotRecompute(), eg from the UI.
+static void slotUrgentStatsTX(SlotContext &ctx) { startUrgentStatsTX(ctx); }
+#endif // defined(ENABLE_STATS_TX) && defined(ENABLE_ADAPTIVE_STATS_TX)
+
+// Stats samples; should never be missed.
+static void slotStatsSample(SlotContext &)
+  {
+  // Update non-volatile stats.
+  // Make the final update as near the end of the hour as possible to reduce glitches (TODO-1086),
+  // and with other optional non-full samples evenly spaced throughout the hour.
+  // Race-free.
+  const uint_least16_t msm = OTV0P2BASE::getMinutesSinceMidnightLT();
+  const uint8_t mm = msm % 60;
+  if(59 == mm)
+    {
+    statsU.sampleStats(true, uint8_t(msm / 60));
+#if defined(ENABLE_ENERGY_LEDGER)
+    energyLedger.endOfHour(uint8_t(msm / 60));
+#endif
+    }
+  else if((statsU.maxSamplesPerHour > 1) && (29 == mm)) { statsU.sampleStats(false, uint8_t(msm / 60)); }
+  }
+
+// The schedule.
+// Budgets are rough worst cases at 1MHz: ADC reads ~1 tick,
+// SHT21 conversions ~4 (RH) and ~11 (temperature) ticks, EEPROM writes ~3.3ms each,
+// and a stats TX includes up to a quarter-cycle random wait plus serial and radio output.
+static constexpr SlotTask slotTasks[] =
+  {
+  {  0,  0, 32, 0, slotMinuteTasks },
+  {  2,  2,  1, SLOT_RUN_ALL_ONLY, slotSeedRNG },
+  {  4,  4,  2, SLOT_RUN_ALL_ONLY, slotSupply },
+#if defined(ENABLE_STATS_TX)
+  {  6,  6,  1, 0, slotStatsTXPick },
+  {  8, 22, 128, 0, slotStatsTX },
+#endif
+#if defined(ENABLE_SECURE_RADIO_BEACON)
+  { 30, 30, 32, 0, slotBeacon },
+#endif
+#if defined(ENABLE_ASYNC_TEMP_SENSOR)
+  { 52, 52,  1, 0, slotSensorsStart },
+#endif
+  { 54, 54, 32, 0, slotSensors },
+  { 56, 56, 16, 0, slotRecompute },
+  { 58, 58, 16, 0, slotStatsSample },
+#if defined(ENABLE_STATS_TX) && defined(ENABLE_ADAPTIVE_STATS_TX)
+  { 24, 58, 64, SLOT_FILL, slotUrgentStatsTX },
+#endif
+  };
+static constexpr uint8_t SLOT_TASKS = sizeof(slotTasks) / sizeof(slotTasks[0]);
+static constexpr uint8_t SLOT_NONE = 0xff;
+
+// Compile-time lookups over slotTasks.
+static constexpr bool slotTaskCovers(const uint8_t i, const uint8_t tlsd)
+  { return((tlsd >= slotTasks[i].first) && (tlsd <= slotTasks[i].last)); }
+// Number of non-fill tasks registered in the slot, from task i onwards.
+static constexpr uint8_t slotTaskCount(const uint8_t tlsd, const uint8_t i = 0)
+  {
+  return((i >= SLOT_TASKS) ? 0 :
+      (((0 == (slotTasks[i].flags & SLOT_FILL)) && slotTaskCovers(i, tlsd)) ? 1 : 0) + slotTaskCount(tlsd, i + 1));
+  }
+// Index of the first task (fill or not) matching the slot, else SLOT_NONE.
+static constexpr uint8_t slotTaskFind(const uint8_t tlsd, const bool fill, const uint8_t i = 0)
+  {
+  return((i >= SLOT_TASKS) ? SLOT_NONE :
+      (((0 != (slotTasks[i].flags & SLOT_FILL)) == fill) && slotTaskCovers(i, tlsd)) ? i : slotTaskFind(tlsd, fill, i + 1));
+  }
+// Task to run in the slot: its own if any, else any fill task.
+static constexpr uint8_t slotTaskIndex(const uint8_t tlsd)
+  { return((SLOT_NONE != slotTaskFind(tlsd, false)) ? slotTaskFind(tlsd, false) : slotTaskFind(tlsd, true)); }
+static constexpr uint8_t fillTaskCount(const uint8_t i = 0)
+  { return((i >= SLOT_TASKS) ? 0 : ((0 != (slotTasks[i].flags & SLOT_FILL)) ? 1 : 0) + fillTaskCount(i + 1)); }
+// True if each even slot from tlsd onwards has at most one task and all within budget.
+static constexpr bool slotsValid(const uint8_t tlsd = 0)
+  {
+  return((tlsd >= 60) ? true :
+      (slotTaskCount(tlsd) <= 1) &&
+      ((SLOT_NONE == slotTaskIndex(tlsd)) || (slotTasks[slotTaskIndex(tlsd)].budgetSCT <= SLOT_BUDGET_MAX_SCT)) &&
+      slotsValid(tlsd + 2));
+  }
+static constexpr bool slotTasksEven(const uint8_t i = 0)
+  { return((i >= SLOT_TASKS) ? true : (0 == (slotTasks[i].first & 1)) && (slotTasks[i].last < 60) && slotTasksEven(i + 1)); }
+static_assert(slotTasksEven(), "slot tasks must start on even TIME_LSD within the minute");
+static_assert(fillTaskCount() <= 1, "at most one fill slot task");
+static_assert(slotsValid(), "slot with more than one task or over budget");
+
+// Flat dispatch table, one entry per even TIME_LSD.
+struct SlotEntry { slotTask_fn_t *fn; uint8_t flags; };
+static constexpr SlotEntry slotEntry(const uint8_t tlsd)
+  { return((SLOT_NONE == slotTaskIndex(tlsd)) ? SlotEntry{ NULL, 0 } : SlotEntry{ slotTasks[slotTaskIndex(tlsd)].fn, slotTasks[slotTaskIndex(tlsd)].flags }); }
+#define SLOT_ENTRIES_10(s) slotEntry(s), slotEntry(s+2), slotEntry(s+4), slotEntry(s+6), slotEntry(s+8), \
+    slotEntry(s+10), slotEntry(s+12), slotEntry(s+14), slotEntry(s+16), slotEntry(s+18)
+static const SlotEntry slotDispatch[30] PROGMEM = { SLOT_ENTRIES_10(0), SLOT_ENTRIES_10(20), SLOT_ENTRIES_10(40) };
+#undef SLOT_ENTRIES_10
+
+// The fill task, if any, for odd seconds (without V0P2BASE_TWO_S_TICK_RTC_SUPPORT).
+static constexpr uint8_t slotFillIndex(const uint8_t i = 0)
+  { return((i >= SLOT_TASKS) ? SLOT_NONE : (0 != (slotTasks[i].flags & SLOT_FILL)) ? i : slotFillIndex(i + 1)); }
+static constexpr uint8_t SLOT_FILL_INDEX = slotFillIndex();
+static constexpr bool slotFillCovers(const uint8_t tlsd)
+  { return((SLOT_NONE != SLOT_FILL_INDEX) && slotTaskCovers(SLOT_FILL_INDEX, tlsd)); }
+static constexpr slotTask_fn_t *slotFillFn() { return((SLOT_NONE == SLOT_FILL_INDEX) ? NULL : slotTasks[SLOT_FILL_INDEX].fn); }
+
+// Multi-cycle jobs (see CoTask.h), run in this order after the slot task each minor cycle.
+struct CoJob { coJob_fn_t *fn; CoTask *task; };
+static const CoJob coJobs[] PROGMEM =
+  {
+#if defined(_PREPARED_STATS_TX_)
+  { jobStatsTXPrepare, &statsTXPrepareJob },
+#endif
+#if defined(ENABLE_STATS_TX)
+  { jobStatsTX, &statsTXJob },
+#endif
+  { jobCLIUsage, &cliUsageJob },
+  };
+static constexpr uint8_t CO_JOBS = sizeof(coJobs) / sizeof(coJobs[0]);
+bool isCoJobPending()
+  {
+  for(uint8_t i = 0; i < CO_JOBS; ++i)
+    { if(((CoTask *)pgm_read_ptr(&coJobs[i].task))->pending) { return(true); } }
+  return(false);
+  }
+// Run (or resume) each pending job while there is time left before stopBy.
+// A job that reports completion is stopped here even if it did not reach CO_END().
+static void runCoJobs(const uint8_t stopBy)
+  {
+  for(uint8_t i = 0; i < CO_JOBS; ++i)
+    {
+    if(OTV0P2BASE::getSubCycleTime() >= stopBy) { return; }
+    CoTask *const ct = (CoTask *)pgm_read_ptr(&coJobs[i].task);
+    if(ct->pending && ((coJob_fn_t *)pgm_read_ptr(&coJobs[i].fn))(*ct, stopBy)) { ct->stop(); }
+    }
+  }
+
+#if defined(ENABLE_TICKLESS_IDLE)
+// Next TIME_LSD after tlsd with a slot task to run, or 60 for the start of the next minute.
+// Fill slots are not counted; any urgent work for them keeps every cycle running instead.
+static uint8_t nextBusySlot(const uint8_t tlsd, const bool runAll)
+  {
+  for(uint8_t t = (tlsd | 1) + 1; t < 60; t += 2)
+    {
+    const SlotEntry *const e = slotDispatch + (t >> 1);
+    if((NULL != pgm_read_ptr(&e->fn)) && (runAll || (0 == (pgm_read_byte(&e->flags) & SLOT_RUN_ALL_ONLY)))) { return(t); }
+    }
+  return(60);
+  }
+
+// True if the loop body has to run every minor cycle for now, eg to drive the UI, valve or radio.
+static bool tickNeededEveryCycle()
+  {
+#if defined(ENABLE_CONTINUOUS_RX) || defined(ENABLE_BOILER_HUB)
+  // Listeners and hubs service the radio and boiler output every cycle.
+  return(true);
+#else
+  if(isCoJobPending()) { return(true); }
+#if defined(ENABLE_FHT8VSIMPLE)
+  if(localFHT8VTRVEnabled()) { return(true); }
+#endif
+#if defined(ENABLE_FULL_OT_UI) && defined(valveUI_DEFINED)
+  // Keep the UI, and its LED heartbeat in WARM mode, running.
+  if(valveMode.inWarmMode() || valveUI.veryRecentUIControlUse()) { return(true); }
+#endif
+#if defined(ENABLE_NOMINAL_RAD_VALVE)
+  if(NominalRadValve.isCallingForHeat()) { return(true); }
+#endif
+#if defined(HAS_DORM1_VALVE_DRIVE) && defined(ENABLE_LOCAL_TRV)
+  // Keep polling the motor driver until calibrated and at the target position.
+  if(!ValveDirect.isInNormalRunState() || (ValveDirect.get() != NominalRadValve.get())) { return(true); }
+#endif
+#if defined(ENABLE_FAST_CALL_FOR_HEAT_TX) && defined(ENABLE_OTSECUREFRAME_ENCODING_SUPPORT) && defined(ENABLE_NOMINAL_RAD_VALVE)
+  if(callForHeatTXPending) { return(true); }
+#endif
+#if defined(ENABLE_STATS_TX) && defined(ENABLE_ADAPTIVE_STATS_TX)
+  if(StatsTXPolicy::URGENT == statsTXPolicy.need()) { return(true); }
+#endif
+  return(false);
+#endif
+  }
+
+// True if something arrived during a skipped minor cycle that needs the loop body now.
+static bool tickWakeNeeded()
+  {
+  if(tickWakeRequested) { tickWakeRequested = false; return(true); }
+#if defined(ENABLE_CLI)
+  if(OTV0P2BASE::CLI::isCLIActive()) { return(true); }
+#endif
+#if defined(ENABLE_RADIO_RX)
+  if(0 != PrimaryRadio.getRXMsgsQueued()) { return(true); }
+#endif
+  // Buttons are polled by the UI so may not raise an interrupt.
+  if((fastDigitalRead(BUTTON_MODE_L) == LOW)
+#if defined(BUTTON_LEARN_L)
+     || (fastDigitalRead(BUTTON_LEARN_L) == LOW)
+#endif
+#if defined(BUTTON_LEARN2_L) && (9 != V0p2_REV) // This input is not momentary with REV9.
+     || (fastDigitalRead(BUTTON_LEARN2_L) == LOW)
+#endif
+     ) { return(true); }
+  return(false);
+  }
+#endif // defined(ENABLE_TICKLESS_IDLE)
 
 // Main loop for OpenTRV radiator control.
 // Note: exiting and re-entering can take a little while, handling Arduino background tasks such as serial.
@@ -953,13 +2107,15 @@ void loopOpenTRV()
 
   // Try if very near to end of cycle and thus causing an overrun.
   // Conversely, if not true, should have time to safely log outputs, etc.
-  const uint8_t nearOverrunThreshold = OTV0P2BASE::GSCT_MAX - 8; // ~64ms/~32 serial TX chars of grace time...
+  const uint8_t nearOverrunThreshold = LOOP_NEAR_OVERRUN_SCT;
 //  bool tooNearOverrun = false; // Set flag that can be checked later.
 
 //  if(getSubCycleTime() >= nearOverrunThreshold) { tooNearOverrun = true; }
 
 #if defined(ENABLE_CONTINUOUS_RX)
   const bool needsToListen = setUpContinuousRX();
+  // Receiver will be on for the coming minor cycle.
+  if(needsToListen) { ENERGY_CHARGE(E_RX, ENERGY_UC_RX_CYCLE); }
 #endif
 
 #if defined(ENABLE_BOILER_HUB)
@@ -974,6 +2130,13 @@ void loopOpenTRV()
 #if 0 && defined(DEBUG)
   DEBUG_SERIAL_PRINTLN_FLASHSTRING("*E"); // End-of-cycle sleep.
 #endif
+#if defined(ENABLE_TICKLESS_IDLE)
+  // Skip straight to the next slot task unless something needs every cycle.
+  // The minute (and so runAll) cannot roll over before then.
+  const uint8_t wakeBy = tickNeededEveryCycle() ? 0 :
+    nextBusySlot(TIME_LSD, (!conserveBattery) || minute0From4ForSensors || (minuteCount < 4));
+#endif
+
   //// If missing h/w interrupts for anything that needs rapid response
   //// then AVOID the lowest-power long sleep.
   //
@@ -990,6 +2153,22 @@ void loopOpenTRV()
   OTV0P2BASE::resetRTCWatchDog();
   OTV0P2BASE::enableRTCWatchdog(true);
 #endif
+
+#if defined(ENABLE_TICKLESS_IDLE)
+  // Go straight back to sleep through idle minor cycles,
+  // without rerunning the loop body, until wakeBy or something needs attention.
+  // A TIME_LSD of 0 always runs so that minuteCount and the minute tasks are kept.
+  while((0 != TIME_LSD) && (TIME_LSD < wakeBy) && !tickWakeNeeded())
+    {
+    ENERGY_CHARGE(E_SLEEP, ENERGY_UC_SLEEP_CYCLE);
+    TIME_LSD = OTV0P2BASE::sleepUntilNewCycle<preSleepFn>(TIME_LSD, false);
+#if defined(ENABLE_WATCHDOG_SLOW)
+    OTV0P2BASE::resetRTCWatchDog();
+    OTV0P2BASE::enableRTCWatchdog(true);
+#endif
+    }
+#endif
+
 #if 0 && defined(DEBUG)
   DEBUG_SERIAL_PRINTLN_FLASHSTRING("*S"); // Start-of-cycle wake.
 #endif
@@ -1073,7 +2252,7 @@ void loopOpenTRV()
     }
 
   // Handling the UI may have taken a little while, so process I/O a little.
-  messageQueue.handle(true, PrimaryRadio); // Deal with any pending I/O.
+  handleMessageQueue(); // Deal with any pending I/O.
 
 
 #ifdef ENABLE_MODELLED_RAD_VALVE
@@ -1095,7 +2274,7 @@ void loopOpenTRV()
     useExtraFHT8VTXSlots = localFHT8VTRVEnabled() && FHT8V.FHT8VPollSyncAndTX_Next(doubleTXForFTH8V);
 //    if(useExtraFHT8VTXSlots) { DEBUG_SERIAL_PRINTLN_FLASHSTRING("ES@1"); }
     // Handling the FHT8V may have taken a little while, so process I/O a little.
-    messageQueue.handle(true, PrimaryRadio); // Deal with any pending I/O.
+    handleMessageQueue(); // Deal with any pending I/O.
     }
 #endif
 
@@ -1110,250 +2289,43 @@ void loopOpenTRV()
   // TODO: coordinate temperature reading with time when radio and other heat-generating items are off for more accurate readings.
   const bool runAll = (!conserveBattery) || minute0From4ForSensors || (minuteCount < 4);
 
-  switch(TIME_LSD) // With V0P2BASE_TWO_S_TICK_RTC_SUPPORT only even seconds are available.
-    {
-    case 0:
-      {
-      // Tasks that must be run every minute.
-      ++minuteCount; // Note simple roll-over to 0 at max value.
-      // Force to user's programmed schedule(s), if any, at the correct time.
-      Scheduler.applyUserSchedule(&valveMode, OTV0P2BASE::getMinutesSinceMidnightLT());
-      // Ensure that the RTC has been persisted promptly when necessary.
-      OTV0P2BASE::persistRTC();
-      // Run hourly tasks at the end of the hour.
-      if(59 == OTV0P2BASE::getMinutesLT())
-          {
-          endOfHourTasks();
-          if(23 == OTV0P2BASE::getHoursLT())
-              { endOfDayTasks(); }
-          }
-      break;
-      }
-
-    // Churn/reseed PRNG(s) a little to improve unpredictability in use: should be lightweight.
-    case 2: { if(runAll) { OTV0P2BASE::seedRNG8(minuteCount ^ OTV0P2BASE::getCPUCycleCount() ^ (uint8_t)Supply_cV.get(), OTV0P2BASE::_getSubCycleTime() ^ AmbLight.get(), (uint8_t)TemperatureC16.get()); } break; }
-    // Force read of supply/battery voltage; measure and recompute status (etc) less often when already thought to be low, eg when conserving.
-    case 4: { if(runAll) { Supply_cV.read(); } break; }
-
-#if defined(ENABLE_STATS_TX)
-    // Periodic transmission of stats if NOT driving a local valve (else stats can be piggybacked onto that).
-    // Randomised somewhat between slots and also within the slot to help avoid collisions.
-    static uint8_t txTick;
-    case 6: { txTick = OTV0P2BASE::randRNG8() & 7; break; } // Pick which of the 8 slots to use.
-    case 8: case 10: case 12: case 14: case 16: case 18: case 20: case 22:
-      {
-      // Only the slot where txTick is zero is used.
-      if(0 != txTick--) { break; }
-
-#if defined(ENABLE_FHT8VSIMPLE)
-      // Avoid transmit conflict with FS20; just drop the slot.
-      // We should possibly choose between this and piggybacking stats to avoid busting duty-cycle rules.
-      if(useExtraFHT8VTXSlots && localFHT8VTRVEnabled()) { break; }
-#endif
-
-#if !defined(ENABLE_FREQUENT_STATS_TX) // If ENABLE_FREQUENT_STATS_TX then send every minute regardless.
-      // Stats TX in the minute (#1) after all sensors should have been polled
-      // (so that readings are fresh) and evenly between.
-      // Usually send one frame every 4 minutes, 2 if this is a valve.
-      // No extra stats TX for changed data to reduce information/activity leakage.
-      // Note that all O frames contain the current valve percentage,
-      // which implies that any extra stats TX also speeds response to call-for-heat changes.
-#ifdef ENABLE_NOMINAL_RAD_VALVE
-      // DHD20170113: was once every 4 minutes, but can make boiler response too slow.
-      if(0 == (minuteFrom4 & 1)) { break; }
-#else
-      if(!minute1From4AfterSensors) { break; }
+#if defined(ENABLE_LOOP_PROFILER)
+  const uint8_t slotStartSCT = OTV0P2BASE::getSubCycleTime();
 #endif
-#endif
-
-      // Abort if not allowed to send stats at all.
-      // FIXME: fix this to send bare calls for heat / valve % instead from valves for secure non-FHT8V comms.
-      if(!enableTrailingStatsPayload()) { break; }
-
-      // Sleep randomly up to ~25% of the minor cycle
-      // to spread transmissions and thus help avoid collisions.
-      // (Longer than 25%/0.5s could interfere with other ops such as FHT8V TXes.)
-      const uint8_t stopBy = 1 + (((OTV0P2BASE::GSCT_MAX >> 2) | 7) & OTV0P2BASE::randRNG8());
-      while(OTV0P2BASE::getSubCycleTime() <= stopBy)
-        {
-        // Handle any pending I/O while waiting.
-        if(messageQueue.handle(true, PrimaryRadio)) { continue; }
-        // Sleep a little.
-        OTV0P2BASE::nap(WDTO_15MS, true);
-        }
-
-      // Send stats!
-      // Try for double TX for extra robustness unless:
-      //   * this is a speculative 'extra' TX
-      //   * battery is low
-      //   * this node is a hub so needs to listen as much as possible
-      // This doesn't generally/always need to send binary/both formats
-      // if this is controlling a local FHT8V on which the binary stats can be piggybacked.
-      // Ie, if doesn't have a local TRV then it must send binary some of the time.
-      // Any recently-changed stats value is a hint that a strong transmission might be a good idea.
-#if defined(ENABLE_BINARY_STATS_TX) && defined(ENABLE_FS20_ENCODING_SUPPORT)
-      const bool doBinary = !localFHT8VTRVEnabled() && OTV0P2BASE::randRNG8NextBoolean();
+  // Run this slot's task, if any (see slotTasks).
+#if defined(ENABLE_FHT8VSIMPLE)
+  const bool extraFHT8VTXSlots = useExtraFHT8VTXSlots;
 #else
-      const bool doBinary = false;
-#endif
-      bareStatsTX(!batteryLow && !hubManager.inHubMode() && ss1.changedValue(), doBinary);
-      break;
-      }
-#endif // defined(ENABLE_STATS_TX)
-
-#if defined(ENABLE_SECURE_RADIO_BEACON)
-    // Send a small secure radio beacon "I'm alive!" message regularly if configured.
-    case 30:
-      {
-#if 1 && defined(DEBUG)
-      DEBUG_SERIAL_PRINT_FLASHSTRING("Beacon TX... ");
-#endif
-      // Get the 'building' key for broadcast.
-      uint8_t key[16];
-      if(!OTV0P2BASE::getPrimaryBuilding16ByteSecretKey(key))
-        {
-#if 1 && defined(DEBUG)
-        DEBUG_SERIAL_PRINTLN_FLASHSTRING("!failed (no key)");
-#endif
-        break;
-        }
-      const OTRadioLink::SimpleSecureFrame32or0BodyTXBase::fixed32BTextSize12BNonce16BTagSimpleEnc_ptr_t e = OTAESGCM::fixed32BTextSize12BNonce16BTagSimpleEnc_DEFAULT_STATELESS;
-      const uint8_t txIDLen = OTRadioLink::ENC_BODY_DEFAULT_ID_BYTES;
-      uint8_t buf[OTRadioLink::generateSecureBeaconMaxBufSize];
-      const uint8_t bodylen = OTRadioLink::generateSecureBeaconRawForTX(buf, sizeof(buf), txIDLen, e, NULL, key);
-      // ASSUME FRAMED CHANNEL 0 (but could check with config isUnframed flag).
-      // When sending on a channel with framing, do not explicitly send the frame length byte.
-      // DO NOT attempt to send if construction of the secure frame failed;
-      // doing so may reuse IVs and destroy the cipher security.
-      const bool success = (0 != bodylen) && PrimaryRadio.sendRaw(buf+1, bodylen-1);
-#if 1 && defined(DEBUG)
-      DEBUG_SERIAL_PRINT(success);
-      DEBUG_SERIAL_PRINTLN();
-#endif
-      break;
-      }
-#endif // defined(ENABLE_SECURE_RADIO_BEACON)
-
-// SENSOR READ AND STATS
-//
-// All external sensor reads should be in the second half of the minute (>32) if possible.
-// This is to have them as close to stats collection at the end of the minute as possible,
-// and to allow randomisation of the start-up cycle position in the first 32s to help avoid inter-unit collisions.
-// Also all sources of noise, self-heating, etc, may be turned off for the 'sensor read minute'
-// and thus will have diminished by this point.
-
-#ifdef ENABLE_VOICE_SENSOR
-    // Poll voice detection sensor at a fixed rate.
-    case 46: { Voice.read(); break; }
-#endif
-
-#ifdef TEMP_POT_AVAILABLE
-    // Sample the user-selected WARM temperature target at a fixed rate.
-    // This allows the unit to stay reasonably responsive to adjusting the temperature dial.
-    case 48: { TempPot.read(); break; }
-#endif
-
-    // Read all environmental inputs, late in the cycle.
-#ifdef HUMIDITY_SENSOR_SUPPORT
-    // Sample humidity.
-    case 50: { if(runAll) { RelHumidity.read(); } break; }
+  const bool extraFHT8VTXSlots = false;
 #endif
-
-#if defined(ENABLE_AMBLIGHT_SENSOR)
-    // Poll ambient light level at a fixed rate.
-    // This allows the unit to respond consistently to (eg) switching lights on (eg TODO-388).
-    case 52:
-      {
-      // Force all UI lights off before sampling ambient light level.
-      OTV0P2BASE::LED_HEATCALL_OFF();
-#if defined(LED_UI2_EXISTS) && defined(ENABLE_UI_LED_2_IF_AVAILABLE)
-      // Turn off second UI LED if available.
-      OTV0P2BASE::LED_UI2_OFF();
-#endif
-      AmbLight.read();
-      break;
-      }
-#endif
-
-    // At a hub, sample temperature regularly as late as possible in the minute just before recomputing valve position.
-    // Force a regular read to make stats such as rate-of-change simple and to minimise lag.
-    // TODO: optimise to reduce power consumption when not calling for heat.
-    // TODO: optimise to reduce self-heating jitter when in hub/listen/RX mode.
-    case 54: { TemperatureC16.read(); break; }
-
-    // Compute targets and heat demand based on environmental inputs and occupancy.
-    // This should happen as soon after the latest readings as possible (temperature especially).
-    case 56:
-      {
-#if defined(OTV0P2BASE_ErrorReport_DEFINED)
-      // Age errors/warnings.
-      OTV0P2BASE::ErrorReporter.read();
-#endif
-
-#if defined(ENABLE_OCCUPANCY_SUPPORT)
-      // Update occupancy measures that partially use rolling stats.
-
-      // Update occupancy status (fresh for target recomputation) at a fixed rate.
-      Occupancy.read();
-#endif // defined(ENABLE_OCCUPANCY_SUPPORT)
-
-#ifdef ENABLE_NOMINAL_RAD_VALVE
-      // Recompute target, valve position and call for heat, etc.
-      // Should be called once per minute to work correctly.
-      NominalRadValve.read();
-#endif
-
-#if defined(ENABLE_FHT8VSIMPLE) && defined(ENABLE_LOCAL_TRV) // Only regen when needed.
-      // If there was a change in target valve position,
-      // or periodically in the minute after all sensors should have been read,
-      // precompute some or all of any outgoing frame/stats/etc ready for the next transmission.
-      if(NominalRadValve.isValveMoved() ||
-         (minute1From4AfterSensors && enableTrailingStatsPayload()))
-        {
-        if(localFHT8VTRVEnabled()) { FHT8V.set(NominalRadValve.get() /*, NominalRadValve.isCallingForHeat() */); }
-        }
-
-#if defined(ENABLE_BOILER_HUB)
-      // Feed in the local valve position when calling for heat just as if over the air.
-      // (Does not arrive with the normal FHT8V timing of 2-minute gaps so boiler may turn off out of sync.)
-      if(FHT8V.isControlledValveReallyOpen()) { BoilerHub.remoteCallForHeatRX(FHT8V.nvGetHC(), FHT8V.get(), minuteCount); }
-#endif // defined(ENABLE_BOILER_HUB)
-#elif defined(ENABLE_NOMINAL_RAD_VALVE) && defined(ENABLE_LOCAL_TRV) // Other local valve types, simulate a remote call for heat with a fake ID.
-#if defined(ENABLE_BOILER_HUB)
-      // Feed in the local valve position when calling for heat just as if over the air.
-      if(NominalRadValve.isControlledValveReallyOpen()) { BoilerHub.remoteCallForHeatRX(~0, NominalRadValve.get(), minuteCount); }
-#endif // defined(ENABLE_BOILER_HUB)
+  SlotContext ctx = { runAll, minuteFrom4, minute1From4AfterSensors, batteryLow, extraFHT8VTXSlots, showStatus };
+  if(0 == (TIME_LSD & 1)) // With V0P2BASE_TWO_S_TICK_RTC_SUPPORT only even seconds are available.
+    {
+    const SlotEntry *const e = slotDispatch + (TIME_LSD >> 1);
+    slotTask_fn_t *const fn = (slotTask_fn_t *)pgm_read_ptr(&e->fn);
+    if((NULL != fn) && (runAll || (0 == (pgm_read_byte(&e->flags) & SLOT_RUN_ALL_ONLY)))) { fn(ctx); }
+    }
+  else if(slotFillCovers(TIME_LSD - 1)) { slotFillFn()(ctx); }
+  // Start or continue any multi-cycle jobs, eg as kicked off by the slot task.
+  runCoJobs(nearOverrunThreshold - 1);
+#if defined(ENABLE_LOOP_PROFILER)
+  const uint8_t slotEndSCT = OTV0P2BASE::getSubCycleTime();
+  loopProfiler.recordSlot(TIME_LSD, (slotEndSCT >= slotStartSCT) ? (slotEndSCT - slotStartSCT) : 0xff);
 #endif
 
-#if 1 && defined(DEBUG) && defined(ENABLE_BOILER_HUB) && !defined(ENABLE_TRIMMED_MEMORY)
-      // Track how long since remote call for heat last heard.
-      if(BoilerHub.isBoilerOn())
-        {
-        DEBUG_SERIAL_PRINT_FLASHSTRING("Boiler on, s: ");
-        DEBUG_SERIAL_PRINT(boilerCountdownTicks * OTV0P2BASE::MAIN_TICK_S);
-        DEBUG_SERIAL_PRINTLN();
-        }
+#if defined(ENABLE_RX_CAPTURE)
+  // Stream any captured RX frames, while leaving time for the rest of the cycle.
+  streamRXCapture();
 #endif
 
-      // Show current status if appropriate.
-      if(runAll) { showStatus = true; }
-      break;
-      }
-
-    // Stats samples; should never be missed.
-    case 58:
-      {
-      // Update non-volatile stats.
-      // Make the final update as near the end of the hour as possible to reduce glitches (TODO-1086),
-      // and with other optional non-full samples evenly spaced throughout the hour.
-      // Race-free.
-      const uint_least16_t msm = OTV0P2BASE::getMinutesSinceMidnightLT();
-      const uint8_t mm = msm % 60;
-      if(59 == mm) { statsU.sampleStats(true, uint8_t(msm / 60)); }
-      else if((statsU.maxSamplesPerHour > 1) && (29 == mm)) { statsU.sampleStats(false, uint8_t(msm / 60)); }
-      break;
-      }
+#if defined(ENABLE_FAST_CALL_FOR_HEAT_TX) && defined(ENABLE_OTSECUREFRAME_ENCODING_SUPPORT) && defined(ENABLE_NOMINAL_RAD_VALVE)
+  // Send a pending call-for-heat change if this minor cycle has time in hand, else try again next one.
+  if(callForHeatTXPending && (OTV0P2BASE::getSubCycleTime() < (OTV0P2BASE::GSCT_MAX / 2)))
+    {
+    callForHeatTXPending = false;
+    bareCallForHeatTX();
     }
+#endif
 
 #if defined(ENABLE_FHT8VSIMPLE) && defined(V0P2BASE_TWO_S_TICK_RTC_SUPPORT)
   if(useExtraFHT8VTXSlots)
@@ -1362,7 +2334,7 @@ void loopOpenTRV()
     useExtraFHT8VTXSlots = localFHT8VTRVEnabled() && FHT8V.FHT8VPollSyncAndTX_Next(doubleTXForFTH8V);
 //    if(useExtraFHT8VTXSlots) { DEBUG_SERIAL_PRINTLN_FLASHSTRING("ES@2"); }
     // Handling the FHT8V may have taken a little while, so process I/O a little.
-    messageQueue.handle(true, PrimaryRadio); // Deal with any pending I/O.
+    handleMessageQueue(); // Deal with any pending I/O.
     }
 #endif
 
@@ -1376,13 +2348,13 @@ void loopOpenTRV()
     useExtraFHT8VTXSlots = localFHT8VTRVEnabled() && FHT8V.FHT8VPollSyncAndTX_Next(doubleTXForFTH8V);
 //    if(useExtraFHT8VTXSlots) { DEBUG_SERIAL_PRINTLN_FLASHSTRING("ES@3"); }
     // Handling the FHT8V may have taken a little while, so process I/O a little.
-    messageQueue.handle(true, PrimaryRadio); // Deal with any pending I/O.
+    handleMessageQueue(); // Deal with any pending I/O.
     }
 #endif
 
   // End-of-loop processing, that may be slow.
   // Ensure progress on queued messages ahead of slow work.  (TODO-867)
-  messageQueue.handle(true, PrimaryRadio); // Deal with any pending I/O.
+  handleMessageQueue(); // Deal with any pending I/O.
 
 #if defined(HAS_DORM1_VALVE_DRIVE) && defined(ENABLE_LOCAL_TRV)
   // Handle local direct-drive valve, eg DORM1.
@@ -1412,7 +2384,15 @@ void loopOpenTRV()
   // Note that FHT8V sync will take up at least the first 1s of a 2s subcycle.
   if(!showStatus &&
      (OTV0P2BASE::getSubCycleTime() < ((OTV0P2BASE::GSCT_MAX/4)*3)))
-    { ValveDirect.read(); }
+    {
+    LOOP_PROFILE_TASK(TASK_VALVE_DIRECT);
+    // Charge motor current only if the driver may run the motor in this poll,
+    // ie while withdrawing the pin, calibrating or moving to a new target,
+    // not when waiting to be fitted or idle at its target.
+    ENERGY_CHARGE_TICKS(E_MOTOR, (ValveDirect.isWaitingForValveToBeFitted() ||
+        (ValveDirect.isInNormalRunState() && (ValveDirect.get() == NominalRadValve.get()))) ? 0 : ENERGY_UC_MOTOR_TICK);
+    ValveDirect.read();
+    }
 #endif
 
   // Command-Line Interface (CLI) polling.
@@ -1422,11 +2402,14 @@ void loopOpenTRV()
   // using a timeout which should safely avoid overrun, ie missing the next basic tick,
   // and which should also allow some energy-saving sleep.
 #if 1 && defined(ENABLE_CLI)
-  if(OTV0P2BASE::CLI::isCLIActive())
+  // Wait for any usage printout to finish before prompting again.
+  if(OTV0P2BASE::CLI::isCLIActive() && !cliUsageJob.pending)
     {
     const uint8_t stopBy = nearOverrunThreshold - 1;
-    char buf[BUFSIZ_pollUI];
-    OTV0P2BASE::ScratchSpace s((uint8_t*)buf, sizeof(buf));
+    WORKSPACE_CLAIM(WS_CLI);
+    OTV0P2BASE::ScratchSpace s(workspaceFor<WS_CLI>(), WorkspacePlan::size(WS_CLI));
+    LOOP_PROFILE_TASK(TASK_CLI);
+    ENERGY_CHARGE_TICKS(E_SERIAL, ENERGY_UC_SERIAL_TICK);
     pollCLI(stopBy, 0 == TIME_LSD, s);
     }
 #endif
@@ -1444,6 +2427,15 @@ void loopOpenTRV()
     }
 #endif
 
+#if defined(ENABLE_LOOP_PROFILER)
+  // Note which slot's loop ended late, if any.
+  loopProfiler.recordLoopEnd(TIME_LSD, OTV0P2BASE::getSubCycleTime(), TIME_LSD != OTV0P2BASE::getSecondsLT());
+#endif
+  // Charge CPU time awake this minor cycle at 1MHz (including any naps, so an over-estimate) and the sleep floor;
+  // CPUBoost adds the extra for any boosted time.
+  ENERGY_CHARGE(E_CPU, (uint32_t)ENERGY_UC_CPU_TICK * OTV0P2BASE::_getSubCycleTime());
+  ENERGY_CHARGE(E_SLEEP, ENERGY_UC_SLEEP_CYCLE);
+
 // Do explicit overrun detection iff RTC watchdog not enabled (should reset instead).
 #if !defined(ENABLE_WATCHDOG_SLOW) // || !defined(ENABLE_TRIMMED_MEMORY) // Could reinstate if not short memory...
   // Detect and handle (actual or near) overrun, if it happens, though it should not.
@@ -0,0 +1,107 @@
+/*
+The OpenTRV project licenses this file to you
+under the Apache Licence, Version 2.0 (the "Licence");
+you may not use this file except in compliance
+with the Licence. You may obtain a copy of the Licence at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the Licence is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied. See the Licence for the
+specific language governing permissions and limitations
+under the Licence.
+
+Author(s) / Copyright (s): Damon Hart-Davis 2017
+*/
+
+/*
+  Radio RX capture: a compact binary record of every frame
+  offered to the primary radio RX queue, for offline analysis.
+
+  Record layout (a capture file is just records back to back, read in order):
+    [0]    raw frame length n as received, before filtering
+    [1]    length kept by the RX filter, 0 if rejected
+    [2]    flags: RXCAP_F_ACCEPTED, RXCAP_F_LOST (records were lost before this one,
+           either dropped by the RX ISR for lack of space or too big for the reader)
+    [3]    RSSI: always 0 from V0p2_Main, as OTRadioLink does not expose it,
+           so captures carry no signal strength
+    [4..5] local minutes since midnight, most significant byte first
+    [6]    local seconds
+    [7]    sub-cycle time (ticks of ~8ms)
+    [8..]  n raw frame bytes
+  On Serial each record is one line: '%' then the record in hex.
+
+  Portable (no Arduino dependencies) so that host tools can use it;
+  see util/V0p2_host/RXCapture/.
+  */
+
+#ifndef RX_CAPTURE_H
+#define RX_CAPTURE_H
+
+#include <stdint.h>
+
+static constexpr uint8_t RXCAP_HEADER_BYTES = 8;
+static constexpr uint8_t RXCAP_F_ACCEPTED = 1;
+static constexpr uint8_t RXCAP_F_LOST = 2;
+// Leading character of a record line on Serial.
+static constexpr char RXCAP_SERIAL_PREFIX = '%';
+
+// Single-producer (RX ISR), single-consumer (main loop) ring of capture records.
+// N is the ring size in bytes, at most 255;
+// records that do not fit are dropped and flagged on the next one that does.
+template <uint8_t N>
+class RXCaptureRing final
+  {
+  private:
+    volatile uint8_t ring[N];
+    // Next byte to write (ISR) and to read (main loop); empty when equal.
+    volatile uint8_t head, tail;
+    // Set by the ISR when a record is dropped.
+    volatile bool lost;
+    // Set by get() when it discards a record too big for its caller.
+    bool skipped;
+
+    uint8_t used() const { const uint8_t h = head, t = tail; return((h >= t) ? (h - t) : (N - t + h)); }
+
+  public:
+    RXCaptureRing() : head(0), tail(0), lost(false), skipped(false) { }
+
+    // Record a frame; call from the RX ISR only.
+    void recordISR(const volatile uint8_t *const frame, const uint8_t rawLen, const uint8_t keptLen, const bool accepted,
+                   const uint8_t rssi, const uint16_t minutes, const uint8_t seconds, const uint8_t sct)
+      {
+      const uint8_t total = RXCAP_HEADER_BYTES + rawLen;
+      if((rawLen > N - RXCAP_HEADER_BYTES) || (total >= N - used())) { lost = true; return; }
+      const uint8_t hdr[RXCAP_HEADER_BYTES] =
+        { rawLen, keptLen, (uint8_t)((accepted ? RXCAP_F_ACCEPTED : 0) | (lost ? RXCAP_F_LOST : 0)), rssi,
+          (uint8_t)(minutes >> 8), (uint8_t)minutes, seconds, sct };
+      uint8_t h = head;
+      for(uint8_t i = 0; i < RXCAP_HEADER_BYTES; ++i) { ring[h] = hdr[i]; if(++h >= N) { h = 0; } }
+      for(uint8_t i = 0; i < rawLen; ++i) { ring[h] = frame[i]; if(++h >= N) { h = 0; } }
+      lost = false;
+      head = h; // Publish.
+      }
+
+    // Copy out the oldest record, if any, into out of size outSize.
+    // Returns the record length, or 0 if none waiting.
+    // A record too big for out is discarded and the next one returned marked RXCAP_F_LOST.
+    uint8_t get(uint8_t *const out, const uint8_t outSize)
+      {
+      while(head != tail)
+        {
+        uint8_t t = tail;
+        const uint8_t total = RXCAP_HEADER_BYTES + ring[t];
+        const bool fits = (total <= outSize);
+        for(uint8_t i = 0; i < total; ++i) { if(fits) { out[i] = ring[t]; } if(++t >= N) { t = 0; } }
+        tail = t; // Release.
+        if(!fits) { skipped = true; continue; }
+        if(skipped) { out[2] |= RXCAP_F_LOST; skipped = false; }
+        return(total);
+        }
+      return(0);
+      }
+  };
+
+#endif
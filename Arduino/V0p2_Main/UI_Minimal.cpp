@@ -69,94 +69,115 @@ static bool extCLIHandler(Print *const p, char *const buf, const uint8_t n)
 #if defined(ENABLE_CLI_HELP) && !defined(ENABLE_TRIMMED_MEMORY)
 #define _CLI_HELP_
 static constexpr uint8_t SYNTAX_COL_WIDTH = 10; // Width of 'syntax' column; strictly positive.
-// Estimated maximum overhead in sub-cycle ticks to print full line and all trailing CLI summary info.
-static constexpr uint8_t CLI_PRINT_OH_SCT = ((uint8_t)(OTV0P2BASE::GSCT_MAX/4));
-// Deadline in minor cycle by which to stop printing description.
-static constexpr uint8_t STOP_PRINTING_DESCRIPTION_AT = ((uint8_t)(OTV0P2BASE::GSCT_MAX-CLI_PRINT_OH_SCT));
+// Estimated maximum time in sub-cycle ticks to print one full line (~50 chars at 4800 baud).
+static constexpr uint8_t CLI_PRINT_LINE_SCT = 16;
 // Efficiently print a single line given the syntax element and the description, both non-null.
-// NOTE: will skip the description if getting close to the end of the time deadline, in order to avoid overrun.
-static void printCLILine(const uint8_t deadline, __FlashStringHelper const *syntax, __FlashStringHelper const *description)
+static void printCLILine(__FlashStringHelper const *syntax, __FlashStringHelper const *description)
   {
   Serial.print(syntax);
-  OTV0P2BASE::flushSerialProductive(); // Ensure all pending output is flushed before sampling current position in minor cycle.
-  if(OTV0P2BASE::getSubCycleTime() >= deadline) { Serial.println(); return; }
   for(int8_t padding = SYNTAX_COL_WIDTH - strlen_P((const char *)syntax); --padding >= 0; ) { OTV0P2BASE::Serial_print_space(); }
   Serial.println(description);
   }
 // Efficiently print a single line given a single-char syntax element and the description, both non-null.
-// NOTE: will skip the description if getting close to the end of the time deadline to avoid overrun.
-static void printCLILine(const uint8_t deadline, const char syntax, __FlashStringHelper const *description)
+static void printCLILine(const char syntax, __FlashStringHelper const *description)
   {
   Serial.print(syntax);
-  OTV0P2BASE::flushSerialProductive(); // Ensure all pending output is flushed before sampling current position in minor cycle.
-  if(OTV0P2BASE::getSubCycleTime() >= deadline) { Serial.println(); return; }
   for(int8_t padding = SYNTAX_COL_WIDTH - 1; --padding >= 0; ) { OTV0P2BASE::Serial_print_space(); }
   Serial.println(description);
   }
+// Print one usage line, first yielding to the next minor cycle if too near the deadline to finish it.
+// Pending output is flushed before sampling the current position in the minor cycle.
+#define CLI_USAGE_LINE(syntax, description) do { OTV0P2BASE::flushSerialProductive(); \
+    CO_YIELD_IF_LATE(ct, deadline); printCLILine((syntax), (description)); } while(0)
 #endif // defined(ENABLE_CLI_HELP) && !defined(ENABLE_TRIMMED_MEMORY)
 
 // Dump some brief CLI usage instructions to serial TX, which must be up and running.
-// If this gets too big there is a risk of overrunning and missing the next tick...
-static void dumpCLIUsage(const uint8_t stopBy)
+// Yields (see CoTask.h) rather than risk overrunning and missing the next tick,
+// so may take a few minor cycles to complete.
+static bool dumpCLIUsage(CoTask &ct, const uint8_t stopBy)
   {
 #ifndef _CLI_HELP_
+  (void) stopBy;
   OTV0P2BASE::CLI::InvalidIgnored(); // Minimal placeholder.
+  ct.stop();
+  return(true);
 #else
-  const uint8_t deadline = OTV0P2BASE::fnmin((uint8_t)(stopBy - OTV0P2BASE::fnmin(stopBy,CLI_PRINT_OH_SCT)), STOP_PRINTING_DESCRIPTION_AT);
+  const uint8_t deadline = stopBy - OTV0P2BASE::fnmin(stopBy, CLI_PRINT_LINE_SCT);
+  CO_BEGIN(ct);
   Serial.println();
   //Serial.println(F("CLI usage:"));
-  printCLILine(deadline, '?', F("this help"));
+  CLI_USAGE_LINE('?', F("this help"));
   
   // Core CLI features first... (E, [H], I, S V)
-  printCLILine(deadline, 'E', F("Exit CLI"));
+  CLI_USAGE_LINE('E', F("Exit CLI"));
 #if defined(ENABLE_FHT8VSIMPLE) && defined(ENABLE_LOCAL_TRV)
-  printCLILine(deadline, F("H H1 H2"), F("set FHT8V House codes 1&2"));
-  printCLILine(deadline, 'H', F("clear House codes"));
+  CLI_USAGE_LINE(F("H H1 H2"), F("set FHT8V House codes 1&2"));
+  CLI_USAGE_LINE('H', F("clear House codes"));
+#endif
+  CLI_USAGE_LINE(F("I *"), F("create new ID"));
+  CLI_USAGE_LINE('S', F("show Status"));
+  CLI_USAGE_LINE('V', F("sys Version"));
+#if defined(ENABLE_LOOP_PROFILER)
+  CLI_USAGE_LINE(F("U [!]"), F("dump [clear] loop profile"));
+#endif
+#if defined(ENABLE_ENERGY_LEDGER)
+  CLI_USAGE_LINE(F("B [!]"), F("dump [clear] energy use uAh"));
+#endif
+#if defined(ENABLE_CPU_BOOST) && defined(ENABLE_OTSECUREFRAME_ENCODING_SUPPORT)
+  CLI_USAGE_LINE('Y', F("CPU boost crypto benchmark"));
 #endif
-  printCLILine(deadline, F("I *"), F("create new ID"));
-  printCLILine(deadline, 'S', F("show Status"));
-  printCLILine(deadline, 'V', F("sys Version"));
 #ifdef ENABLE_GENERIC_PARAM_CLI_ACCESS
-  printCLILine(deadline, F("G N [M]"), F("Show [set] generic param N [to M]")); // *******
+  CLI_USAGE_LINE(F("G N [M]"), F("Show [set] generic param N [to M]")); // *******
 #endif
 
 #ifdef ENABLE_FULL_OT_CLI
   // Optional CLI features...
   Serial.println(F("-"));
 #if defined(ENABLE_BOILER_HUB) || defined(ENABLE_STATS_RX)
-  printCLILine(deadline, F("C M"), F("Central hub >=M mins on, 0 off"));
+  CLI_USAGE_LINE(F("C M"), F("Central hub >=M mins on, 0 off"));
 #endif
-  printCLILine(deadline, F("D N"), F("Dump stats set N"));
-  printCLILine(deadline, 'F', F("Frost"));
+  CLI_USAGE_LINE(F("D N"), F("Dump stats set N"));
+  CLI_USAGE_LINE('F', F("Frost"));
 #if defined(ENABLE_SETTABLE_TARGET_TEMPERATURES) && !defined(TEMP_POT_AVAILABLE)
-  printCLILine(deadline, F("F CC"), F("set Frost/setback temp CC"));
+  CLI_USAGE_LINE(F("F CC"), F("set Frost/setback temp CC"));
 #endif
 
-  //printCLILine(deadline, 'L', F("Learn to warm every 24h from now, clear if in frost mode, schedule 0"));
+  //CLI_USAGE_LINE('L', F("Learn to warm every 24h from now, clear if in frost mode, schedule 0"));
 #if defined(SCHEDULER_AVAILABLE)
-  printCLILine(deadline, F("L S"), F("Learn daily warm now, clear if in frost mode, schedule S"));
-  //printCLILine(deadline, F("P HH MM"), F("Program: warm daily starting at HH MM schedule 0"));
-  printCLILine(deadline, F("P HH MM S"), F("Program: warm daily starting at HH MM schedule S"));
+  CLI_USAGE_LINE(F("L S"), F("Learn daily warm now, clear if in frost mode, schedule S"));
+  //CLI_USAGE_LINE(F("P HH MM"), F("Program: warm daily starting at HH MM schedule 0"));
+  CLI_USAGE_LINE(F("P HH MM S"), F("Program: warm daily starting at HH MM schedule S"));
 #endif
-  printCLILine(deadline, F("O PP"), F("min % for valve to be Open"));
+  CLI_USAGE_LINE(F("O PP"), F("min % for valve to be Open"));
 #if defined(ENABLE_NOMINAL_RAD_VALVE)
-  printCLILine(deadline, 'O', F("reset Open %"));
+  CLI_USAGE_LINE('O', F("reset Open %"));
 #endif
-  printCLILine(deadline, 'Q', F("Quick Heat"));
-//  printCLILine(deadline, F("R N"), F("dump Raw stats set N"));
+  CLI_USAGE_LINE('Q', F("Quick Heat"));
+//  CLI_USAGE_LINE(F("R N"), F("dump Raw stats set N"));
 
-  printCLILine(deadline, F("T HH MM"), F("set 24h Time"));
-  printCLILine(deadline, 'W', F("Warm"));
+  CLI_USAGE_LINE(F("T HH MM"), F("set 24h Time"));
+  CLI_USAGE_LINE('W', F("Warm"));
 #if defined(ENABLE_SETTABLE_TARGET_TEMPERATURES) && !defined(TEMP_POT_AVAILABLE)
-  printCLILine(deadline, F("W CC"), F("set Warm temp CC"));
+  CLI_USAGE_LINE(F("W CC"), F("set Warm temp CC"));
 #endif
 #if !defined(ENABLE_ALWAYS_TX_ALL_STATS)
-  printCLILine(deadline, 'X', F("Xmit security level; 0 always, 255 never"));
+  CLI_USAGE_LINE('X', F("Xmit security level; 0 always, 255 never"));
 #endif
-  printCLILine(deadline, 'Z', F("Zap stats"));
+  CLI_USAGE_LINE('Z', F("Zap stats"));
 #endif // ENABLE_FULL_OT_CLI
-#endif // ENABLE_CLI_HELP
   Serial.println();
+  CO_END(ct);
+#endif // ENABLE_CLI_HELP
+  }
+
+CoTask cliUsageJob;
+bool jobCLIUsage(CoTask &ct, const uint8_t stopBy)
+  {
+  const bool neededWaking = OTV0P2BASE::powerUpSerialIfDisabled<V0P2_UART_BAUD>();
+  const bool done = dumpCLIUsage(ct, stopBy);
+  OTV0P2BASE::flushSerialSCTSensitive();
+  if(neededWaking) { OTV0P2BASE::powerDownSerial(); }
+  return(done);
   }
 
 //#if defined(ENABLE_EXTENDED_CLI) || defined(ENABLE_OTSECUREFRAME_ENCODING_SUPPORT)
@@ -197,7 +218,7 @@ void pollCLI(const uint8_t maxSCT, const bool startOfMinute, const OTV0P2BASE::S
       {
       // Explicit request for help, or unrecognised first character.
       // Avoid showing status as may already be rather a lot of output.
-      default: case '?': { dumpCLIUsage(maxSCT); showStatus = false; break; }
+      default: case '?': { cliUsageJob.start(); showStatus = false; break; }
 
       // Exit/deactivate CLI immediately.
       // This should be followed by JUST CR ('\r') OR LF ('\n')
@@ -261,6 +282,36 @@ void pollCLI(const uint8_t maxSCT, const bool startOfMinute, const OTV0P2BASE::S
         }
 #endif // !defined(ENABLE_TRIMMED_MEMORY)
 
+#if defined(ENABLE_LOOP_PROFILER)
+      // Dump loop profile in sub-cycle ticks, or clear it with U!
+      // Task numbers are in LoopProfiler::task_t order.
+      // Avoid showing status afterwards as may already be rather a lot of output.
+      case 'U':
+        {
+        if((n == 2) && ('!' == buf[1])) { loopProfiler.reset(); }
+        else { loopProfiler.dump(Serial, maxSCT); }
+        showStatus = false;
+        break;
+        }
+#endif // defined(ENABLE_LOOP_PROFILER)
+
+#if defined(ENABLE_CPU_BOOST) && defined(ENABLE_OTSECUREFRAME_ENCODING_SUPPORT)
+      // Benchmark secure frame encryption at 1MHz and boosted.
+      case 'Y': { benchmarkCPUBoost(Serial); showStatus = false; break; }
+#endif // defined(ENABLE_CPU_BOOST) && defined(ENABLE_OTSECUREFRAME_ENCODING_SUPPORT)
+
+#if defined(ENABLE_ENERGY_LEDGER)
+      // Dump estimated energy use in uAh, or clear it with B!
+      // Subsystems are in EnergyLedger::subsystem_t order.
+      case 'B':
+        {
+        if((n == 2) && ('!' == buf[1])) { energyLedger.reset(); }
+        else { energyLedger.dump(Serial, maxSCT); }
+        showStatus = false;
+        break;
+        }
+#endif // defined(ENABLE_ENERGY_LEDGER)
+
 #ifdef ENABLE_EXTENDED_CLI
       // Handle CLI extension commands.
       // Command of form:
@@ -282,7 +333,14 @@ void pollCLI(const uint8_t maxSCT, const bool startOfMinute, const OTV0P2BASE::S
 #if defined(ENABLE_OTSECUREFRAME_ENCODING_SUPPORT) && (defined(ENABLE_BOILER_HUB) || defined(ENABLE_STATS_RX)) && defined(ENABLE_RADIO_RX)
       // Set new node association (nodes to accept frames from).
       // Only needed if able to RX and/or some sort of hub.
-      case 'A': { showStatus = OTV0P2BASE::CLI::SetNodeAssoc().doCommand(buf, n); break; }
+      case 'A':
+        {
+        showStatus = OTV0P2BASE::CLI::SetNodeAssoc().doCommand(buf, n);
+#if defined(ENABLE_RX_ASSOC_PREFILTER)
+        rebuildRXAssocPrefilter(); // Keep the RX prefilter in step.
+#endif
+        break;
+        }
 #endif // ENABLE_OTSECUREFRAME_ENCODING_SUPPORT
 
 #if defined(ENABLE_RADIO_RX) && (defined(ENABLE_BOILER_HUB) || defined(ENABLE_STATS_RX)) && !defined(ENABLE_DEFAULT_ALWAYS_RX)
@@ -358,7 +416,14 @@ void pollCLI(const uint8_t maxSCT, const bool startOfMinute, const OTV0P2BASE::S
        *        function pointer MUST be passed here to ensure safe handling of the key and the Tx message
        *        counter.
        */
-      case 'K': { showStatus = OTV0P2BASE::CLI::SetSecretKey(OTRadioLink::SimpleSecureFrame32or0BodyTXV0p2::resetRaw3BytePersistentTXRestartCounterCond).doCommand(buf, n); break; }
+      case 'K':
+        {
+        showStatus = OTV0P2BASE::CLI::SetSecretKey(OTRadioLink::SimpleSecureFrame32or0BodyTXV0p2::resetRaw3BytePersistentTXRestartCounterCond).doCommand(buf, n);
+#if defined(ENABLE_CACHED_AESGCM_CONTEXT)
+        aesgcmContext.clear(); // Do not keep a replaced or cleared key.
+#endif
+        break;
+        }
 #endif // ENABLE_OTSECUREFRAME_ENCODING_SUPPORT
 
 // FIXME
@@ -472,6 +537,11 @@ void pollCLI(const uint8_t maxSCT, const bool startOfMinute, const OTV0P2BASE::S
 #endif // ENABLE_FULL_OT_CLI // NON-CORE FEATURES
       }
 
+#if defined(ENABLE_CONFIG_CACHE)
+    // Pick up any config the command may have changed in EEPROM.
+    if(NULL != strchr("GHIX", buf[0])) { configCache.reload(); }
+#endif
+
     // Almost always show status line afterwards as feedback of command received and new state.
     if(showStatus) { serialStatusReport(); }
     // Else show ack of command received.
@@ -31,6 +31,20 @@ Author(s) / Copyright (s): Damon Hart-Davis 2013--2017
 // GLOBAL flags that alter system build and behaviour.
 //#define DEBUG // If defined, do extra checks and serial logging.  Will take more code space and power.
 //#define EST_CPU_DUTYCYCLE // If defined, estimate CPU duty cycle and thus base power consumption.
+//#define ENABLE_LOOP_PROFILER // If defined, profile sub-cycle time per TIME_LSD slot and slow task; 'U' CLI command to dump.
+//#define ENABLE_ENERGY_LEDGER // If defined, estimate charge used per subsystem per hour; 'B' CLI command to dump.
+//#define ENABLE_ADAPTIVE_STATS_TX // If defined, send stats only on change or heartbeat (see StatsTXPolicy), and promptly on call for heat.
+//#define RX_QUEUE_CAPACITY 4 // If defined, primary radio RX queue depth in frames, overriding the per-config default; each frame costs ~64 bytes RAM, eg for a busy hub.
+//#define ENABLE_RX_QUEUE_STATS // If defined, report RX queue drops, filtered frames and high-water mark in stats.
+//#define ENABLE_RX_ASSOC_PREFILTER // If defined, drop secure frames from unassociated nodes in the RX ISR, before queueing or decryption.
+//#define ENABLE_CONFIG_CACHE // If defined, keep a RAM copy of hot EEPROM config (TX privacy level, node ID, FHT8V house codes), reloaded after CLI changes.
+//#define ENABLE_CACHED_AESGCM_CONTEXT // If defined, keep the expanded building key between secure frame encrypts, TX only (AESGCMContext.h); ~200 bytes RAM, +256 with AESGCM_CONTEXT_GHASH_TABLE 1.
+//#define ENABLE_CPU_BOOST // If defined, run the CPU at up to 8MHz around crypto and frame building (CPU_BOOST()); 'Y' CLI command to benchmark.
+//#define ENABLE_RX_CAPTURE // If defined, stream every primary radio RX frame and filter verdict to Serial as RXCapture.h records for offline analysis.
+//#define ENABLE_FAST_CALL_FOR_HEAT_TX // If defined, send a short secure frame as soon as call for heat changes, and hubs switch the boiler on as soon as it is heard (REV10SecureHub: ENABLE_FAST_CALL_FOR_HEAT).
+//#define ENABLE_PREPARED_STATS_TX // If defined, build and encrypt each secure stats frame in spare time before its TX slot, which then only queues it; ~70 bytes RAM.
+//#define ENABLE_TICKLESS_IDLE // If defined, minor cycles with no slot task, UI, radio or CLI work go straight back to sleep without running the loop body.
+//#define ENABLE_ASYNC_TEMP_SENSOR // If defined, start the room temperature conversion a slot before the sensor slot collects it (AsyncTempSensors.h); DS18B20 runs at full precision.
 
 #ifndef BAUD
 // Ensure that OpenTRV 'standard' UART speed is set unless explicitly overridden.
@@ -79,6 +93,26 @@ Author(s) / Copyright (s): Damon Hart-Davis 2013--2017
 #if defined(ENABLE_OTSECUREFRAME_ENCODING_SUPPORT) || defined(ENABLE_SECURE_RADIO_BEACON)
 #include <OTAESGCM.h>
 #endif
+#if defined(ENABLE_CACHED_AESGCM_CONTEXT) && defined(ENABLE_OTSECUREFRAME_ENCODING_SUPPORT)
+#include "AESGCMContext.h"
+#ifndef AESGCM_CONTEXT_GHASH_TABLE
+#define AESGCM_CONTEXT_GHASH_TABLE 0 // 1 for ~4x faster GHASH at 256 bytes of RAM.
+#endif
+// Singleton context for the building key.
+extern AES128GCMContext<(0 != AESGCM_CONTEXT_GHASH_TABLE)> aesgcmContext;
+// Drop-in replacement for the OTAESGCM ..._DEFAULT_WITH_LWORKSPACE encrypt using aesgcmContext;
+// the workspace is not needed.
+// TX only: secure RX decode is compiled out in this sketch, so it keeps the library decrypt.
+bool fixed32BTextSize12BNonce16BTagSimpleEnc_CACHED(OTV0P2BASE::ScratchSpaceL &workspace,
+        const uint8_t *key, const uint8_t *iv,
+        const uint8_t *authtext, uint8_t authtextSize,
+        const uint8_t *plaintext,
+        uint8_t *ciphertextOut, uint8_t *tagOut);
+#define AESGCM_ENC_WITH_LWORKSPACE fixed32BTextSize12BNonce16BTagSimpleEnc_CACHED
+#else
+#define AESGCM_ENC_WITH_LWORKSPACE OTAESGCM::fixed32BTextSize12BNonce16BTagSimpleEnc_DEFAULT_WITH_LWORKSPACE
+#endif
+#define AESGCM_DEC_WITH_LWORKSPACE OTAESGCM::fixed32BTextSize12BNonce16BTagSimpleDec_DEFAULT_WITH_LWORKSPACE
 
 // Indicate that the system is broken in an obvious way (distress flashing of the main UI LED).
 // DOES NOT RETURN.
@@ -156,13 +190,43 @@ inline uint8_t *RFM22RXPreambleAdd(uint8_t *buf)
   }
 #endif
 
+#if defined(ENABLE_CONFIG_CACHE)
+// RAM shadow of EEPROM config read on hot paths, loaded in setup().
+// Must be reloaded after anything that may change the EEPROM values,
+// which in normal running is only the CLI (G, H, I and X commands).
+// The secret key is deliberately not shadowed,
+// so as to keep it out of RAM except briefly while in use.
+class ConfigCache final
+  {
+  private:
+    uint8_t statsTXLevel;
+    uint8_t nodeID[OTV0P2BASE::OpenTRV_Node_ID_Bytes];
+#if defined(ENABLE_FHT8VSIMPLE)
+    uint16_t fht8vHC;
+#endif
+  public:
+    // (Re)load everything from EEPROM.
+    void reload();
+    uint8_t getStatsTXLevel() const { return(statsTXLevel); }
+    uint8_t getNodeIDByte(const uint8_t i) const { return(nodeID[i]); }
+#if defined(ENABLE_FHT8VSIMPLE)
+    uint16_t getFHT8VHC() const { return(fht8vHC); }
+#endif
+  };
+extern ConfigCache configCache;
+inline uint8_t getStatsTXLevelFast() { return(configCache.getStatsTXLevel()); }
+inline uint8_t getNodeIDByteFast(const uint8_t i) { return(configCache.getNodeIDByte(i)); }
+#else
+inline uint8_t getStatsTXLevelFast() { return(OTV0P2BASE::getStatsTXLevel()); }
+inline uint8_t getNodeIDByteFast(const uint8_t i) { return(eeprom_read_byte((uint8_t *)V0P2BASE_EE_START_ID + i)); }
+#endif // defined(ENABLE_CONFIG_CACHE)
+
 // Returns true if an unencrypted trailing static payload and similar (eg bare stats transmission) is permitted.
 // True if the TX_ENABLE value is no higher than stTXmostUnsec.
 // Some filtering may be required even if this is true.
 #if defined(ENABLE_STATS_TX)
 #if !defined(ENABLE_ALWAYS_TX_ALL_STATS)
-// TODO: allow cacheing in RAM for speed.
-inline bool enableTrailingStatsPayload() { return(OTV0P2BASE::getStatsTXLevel() <= OTV0P2BASE::stTXmostUnsec); }
+inline bool enableTrailingStatsPayload() { return(getStatsTXLevelFast() <= OTV0P2BASE::stTXmostUnsec); }
 #else
 #define enableTrailingStatsPayload() (true) // Always allow at least some stats to be TXed.
 #endif // !defined(ENABLE_ALWAYS_TX_ALL_STATS)
@@ -245,15 +309,35 @@ extern OTV0P2BASE::TemperatureC16_DS18B20 extDS18B20_0;
 #endif
 
 // Ambient/room temperature sensor, usually on main board.
+#if defined(ENABLE_ASYNC_TEMP_SENSOR)
+// Conversion started by startRead() and fetched by collectRead() in a later slot.
+#include "AsyncTempSensors.h"
+#endif
 #if defined(ENABLE_PRIMARY_TEMP_SENSOR_SHT21)
-extern OTV0P2BASE::RoomTemperatureC16_SHT21 TemperatureC16; // SHT21 impl.
+#if defined(ENABLE_ASYNC_TEMP_SENSOR)
+typedef RoomTemperatureC16_SHT21_Async TemperatureC16_t;
+#else
+typedef OTV0P2BASE::RoomTemperatureC16_SHT21 TemperatureC16_t;
+#endif
+extern TemperatureC16_t TemperatureC16; // SHT21 impl.
 #elif defined(ENABLE_PRIMARY_TEMP_SENSOR_DS18B20)
   #if defined(ENABLE_MINIMAL_ONEWIRE_SUPPORT)
-  // DSB18B20 temperature impl, with slightly reduced precision to improve speed.
-  extern OTV0P2BASE::TemperatureC16_DS18B20 TemperatureC16;
+  // DSB18B20 temperature impl, with slightly reduced precision to improve speed
+  // unless the conversion is overlapped with sleep.
+  #if defined(ENABLE_ASYNC_TEMP_SENSOR)
+  typedef TemperatureC16_DS18B20_Async TemperatureC16_t;
+  #else
+  typedef OTV0P2BASE::TemperatureC16_DS18B20 TemperatureC16_t;
+  #endif
+  extern TemperatureC16_t TemperatureC16;
   #endif // defined(ENABLE_MINIMAL_ONEWIRE_SUPPORT)
 #else // Don't use TMP112 if SHT21 or DS18B20 have been selected.
-extern OTV0P2BASE::RoomTemperatureC16_TMP112 TemperatureC16;
+#if defined(ENABLE_ASYNC_TEMP_SENSOR)
+typedef RoomTemperatureC16_TMP112_Async TemperatureC16_t;
+#else
+typedef OTV0P2BASE::RoomTemperatureC16_TMP112 TemperatureC16_t;
+#endif
+extern TemperatureC16_t TemperatureC16;
 #endif
 
 // HUMIDITY_SENSOR_SUPPORT is defined if at least one humidity sensor has support compiled in.
@@ -431,7 +515,10 @@ inline void serialStatusReport() { statsLine.serialStatusReport(); }
 // Sends stats on primary radio channel 0 with possible duplicate to secondary channel.
 // If sending encrypted then ID/counter fields (eg @ and + for JSON) are omitted
 // as assumed supplied by security layer to remote recipent.
-void bareStatsTX(bool allowDoubleTX = false, bool doBinary = false);
+//   * prepareOnly  with ENABLE_PREPARED_STATS_TX, keep a finished secure frame
+//     to be queued later rather than sending it now
+// Returns true if a frame was queued for TX (or prepared, with prepareOnly).
+bool bareStatsTX(bool allowDoubleTX = false, bool doBinary = false, bool prepareOnly = false);
 
 #ifdef ENABLE_BOILER_HUB
 extern OTRadValve::BoilerLogic::OnOffBoilerDriverLogic<decltype(hubManager), hubManager, OUT_HEATCALL> BoilerHub;
@@ -469,6 +556,411 @@ static constexpr uint8_t BUFSIZ_pollUI = 1 + MAXIMUM_CLI_RESPONSE_CHARS;
 void pollCLI(uint8_t maxSCT, bool startOfMinute, const OTV0P2BASE::ScratchSpace &s);
 
 
+////////////////////////// Multi-cycle jobs
+
+#include "CoTask.h"
+
+// CLI usage/help printout, started by the '?' command; may span several minor cycles.
+extern CoTask cliUsageJob;
+bool jobCLIUsage(CoTask &ct, uint8_t stopBy);
+
+// True while any multi-cycle job is unfinished.
+bool isCoJobPending();
+
+
+////////////////////////// Shared workspace
+
+// One statically-allocated workspace for all the large scratch buffers,
+// like the hand-built GlobalWorkSpace union of the REV10 sketches,
+// rather than each being on the stack at its point of use.
+// Each user's size is derived from the enabled features (0 when not compiled in)
+// and users share space unless listed in WorkspacePlan::concurrent(),
+// ie unless one can be called while the other's buffer is in use.
+// Offsets are laid out at compile time, and a static_assert checks
+// that no two concurrent users overlap.
+// Keep concurrent() in step with the call graph:
+// with DEBUG, WORKSPACE_CLAIM() reports any undeclared overlap at run time.
+enum ws_user_t : uint8_t
+  {
+  WS_CLI,              // loopOpenTRV() CLI input buffer for pollCLI().
+  WS_STATS_TX,         // bareStatsTX() frame and encryption; also called from the CLI.
+  WS_CPU_BENCH,        // benchmarkCPUBoost() from the CLI.
+  WS_CALL_FOR_HEAT_TX, // bareCallForHeatTX() from a loopOpenTRV() slot.
+  WS_DECODE,           // Secure frame RX decode from the message queue handler.
+  WS_USERS
+  };
+namespace WorkspacePlan
+  {
+  // Stats TX frame: leading length byte + typical 64-byte radio module TX buffer limit + optional terminator.
+  static constexpr uint8_t STATS_MSG_BUF_SIZE = 1 + 64 + 1;
+  // Secure stats JSON buffer for writeJSON(), which wants 2 more than the largest output
+  // (for the trailing null and one byte to detect an over-long message).
+  // The largest output is MSG_JSON_MAX_LENGTH_SECURE, which as sent, without its implied trailing '}',
+  // just fills the fixed-size body after the valvePC and hasStats bytes.
+  static constexpr uint8_t STATS_ENC_JSON_LEN = OTV0P2BASE::MSG_JSON_MAX_LENGTH_SECURE + 2;
+  static_assert(2 + (OTV0P2BASE::MSG_JSON_MAX_LENGTH_SECURE - 1) == OTRadioLink::ENC_BODY_SMALL_FIXED_PTEXT_MAX_SIZE, "secure JSON no longer fills the body");
+  // Secure valve frame plaintext, for stats and call for heat alike (see encodeSecureValveFrame()):
+  // |    0    |     1    | 2 |  3:n | n+1 | n+2 | n is the end of the stats message. n+2 <= 34
+  // | valvePC | hasStats | { | json | '}' | 0x0 |
+  static constexpr uint8_t SECURE_PTEXT_LEN = STATS_ENC_JSON_LEN + 2; // 2 = valvePC + hasStats
+  static_assert(SECURE_PTEXT_LEN == 34, "SECURE_PTEXT_LEN wrong");
+#if defined(ENABLE_OTSECUREFRAME_ENCODING_SUPPORT)
+  static constexpr bool doEnc = true;
+  static constexpr size_t ENC_SCRATCH = OTRadioLink::SimpleSecureFrame32or0BodyTXBase::encodeValveFrame_total_scratch_usage_OTAESGCM_2p0;
+  // Decode: the AES-GCM decrypt workspace, plus 58 bytes used by the
+  // decodeAndHandleOTSecureOFrameWithWorkspace() chain itself (frame header and decrypted body),
+  // plus a spare 16-byte block beyond the library's declared workspaceRequiredDec.
+  // Neither extra is published by the library: these are the figures REV10SecureHub
+  // (Decode_WorkspaceSize) runs with on hardware; only used with secure RX, currently compiled out.
+  static constexpr size_t DECODE_CHAIN_SCRATCH = 58;
+  static constexpr size_t DECODE_AESGCM_MARGIN = 16;
+  static constexpr size_t DECODE_SIZE = OTAESGCM::OTAES128GCMGenericWithWorkspace<>::workspaceRequiredDec + DECODE_CHAIN_SCRATCH + DECODE_AESGCM_MARGIN;
+#else
+  static constexpr bool doEnc = false;
+  static constexpr size_t ENC_SCRATCH = 0;
+#endif
+  // The plaintext and crypto scratch are only needed when encrypting.
+  static constexpr uint8_t STATS_SCRATCH_NEEDED = STATS_MSG_BUF_SIZE + (doEnc ? SECURE_PTEXT_LEN : 0);
+  // Call for heat frame: as for stats, with no stats body and no terminator.
+  static constexpr uint8_t CFH_MSG_BUF_SIZE = 1 + 64;
+  static constexpr uint8_t CFH_SCRATCH_NEEDED = CFH_MSG_BUF_SIZE + SECURE_PTEXT_LEN;
+
+  constexpr size_t size(const ws_user_t u)
+    {
+    return((WS_CLI == u) ?
+#if defined(ENABLE_CLI)
+        BUFSIZ_pollUI
+#else
+        0
+#endif
+      : (WS_STATS_TX == u) ?
+#if defined(ENABLE_STATS_TX)
+        ENC_SCRATCH + STATS_SCRATCH_NEEDED
+#else
+        0
+#endif
+      : (WS_CPU_BENCH == u) ?
+#if defined(ENABLE_CPU_BOOST)
+        ENC_SCRATCH
+#else
+        0
+#endif
+      : (WS_CALL_FOR_HEAT_TX == u) ?
+#if defined(ENABLE_FAST_CALL_FOR_HEAT_TX) && defined(ENABLE_OTSECUREFRAME_ENCODING_SUPPORT) && defined(ENABLE_NOMINAL_RAD_VALVE)
+        ENC_SCRATCH + CFH_SCRATCH_NEEDED
+#else
+        0
+#endif
+      : (WS_DECODE == u) ?
+#if defined(ENABLE_OTSECUREFRAME_ENCODING_SUPPORT) && defined(ENABLE_RADIO_RX) && 0 // XXX as for the V0p2_Main.ino queue handler.
+        DECODE_SIZE
+#else
+        0
+#endif
+      : 0);
+    }
+
+  // Bit mask of the users that may be live at the same time as u.
+  constexpr uint8_t bit(const ws_user_t u) { return((uint8_t)(1U << u)); }
+  constexpr uint8_t concurrent(const ws_user_t u)
+    {
+    return((WS_CLI == u) ? (bit(WS_STATS_TX) | bit(WS_CPU_BENCH)) :
+           (WS_STATS_TX == u) ? bit(WS_CLI) :
+           (WS_CPU_BENCH == u) ? bit(WS_CLI) :
+           0);
+    }
+  constexpr bool conflicts(const ws_user_t a, const ws_user_t b)
+    { return((0 != (concurrent(a) & bit(b))) && (0 != size(a)) && (0 != size(b))); }
+
+  // Each user goes just above the highest earlier user that it conflicts with.
+  constexpr size_t offset(ws_user_t u);
+  constexpr size_t highestConflictingEnd(const ws_user_t u, const uint8_t j)
+    {
+    return((j >= u) ? 0 :
+        OTV0P2BASE::fnmax((size_t)(conflicts(u, (ws_user_t)j) ? (offset((ws_user_t)j) + size((ws_user_t)j)) : 0),
+                          highestConflictingEnd(u, j + 1)));
+    }
+  constexpr size_t offset(const ws_user_t u) { return(highestConflictingEnd(u, 0)); }
+  constexpr size_t end(const ws_user_t u) { return(offset(u) + size(u)); }
+  constexpr size_t total(const uint8_t j = 0)
+    { return((j >= WS_USERS) ? 0 : OTV0P2BASE::fnmax(end((ws_user_t)j), total(j + 1))); }
+
+  // True if no two concurrent users from (i, j) onwards overlap,
+  // and the concurrency declarations are symmetric.
+  constexpr bool disjoint(const ws_user_t a, const ws_user_t b)
+    { return(!conflicts(a, b) || (end(a) <= offset(b)) || (end(b) <= offset(a))); }
+  constexpr bool valid(const uint8_t i = 0, const uint8_t j = 0)
+    {
+    return((i >= WS_USERS) ? true :
+           (j >= WS_USERS) ? valid(i + 1, 0) :
+           ((conflicts((ws_user_t)i, (ws_user_t)j) == conflicts((ws_user_t)j, (ws_user_t)i)) &&
+            ((i == j) || disjoint((ws_user_t)i, (ws_user_t)j)) &&
+            valid(i, j + 1)));
+    }
+  }
+static_assert(WS_USERS <= 8, "concurrency mask too small");
+static_assert(WorkspacePlan::valid(), "workspace users overlap");
+
+// The workspace itself (at least 1 byte so that it always exists).
+extern uint8_t globalWorkSpace[OTV0P2BASE::fnmax((size_t)1, WorkspacePlan::total())];
+// Start of the given user's part of the workspace; use WorkspacePlan::size() bytes from here.
+template<ws_user_t U> inline uint8_t *workspaceFor()
+  {
+  static_assert(0 != WorkspacePlan::size(U), "workspace user not compiled in");
+  return(globalWorkSpace + WorkspacePlan::offset(U));
+  }
+
+#if defined(DEBUG)
+// Marks one user's part of the workspace as in use for the current scope,
+// and complains if an undeclared user is already using it.
+class WorkspaceClaim final
+  {
+  private:
+    static uint8_t live;
+    const ws_user_t user;
+  public:
+    explicit WorkspaceClaim(ws_user_t u);
+    ~WorkspaceClaim() { live &= ~WorkspacePlan::bit(user); }
+  };
+#define WORKSPACE_CLAIM(u) const WorkspaceClaim _workspaceClaim(u)
+#else
+#define WORKSPACE_CLAIM(u) // Not checking.
+#endif // defined(DEBUG)
+
+
+////////////////////////// Profiling
+
+#if defined(ENABLE_LOOP_PROFILER)
+// Lightweight profiler of main loop timing in sub-cycle ticks (~8ms each).
+// Keeps min/max/mean time spent in each TIME_LSD slot of loopOpenTRV()
+// and in selected slow tasks wherever they run,
+// plus a small ring of the most recent loops that ended near or past overrun
+// to show which slot was responsible.
+// Costs ~150 bytes of RAM, so off by default.
+// NOT thread-/ISR- safe; call from the main loop only.
+class LoopProfiler final
+  {
+  public:
+    // Slow tasks timed wherever they are called from.
+    enum task_t : uint8_t { TASK_STATS_TX, TASK_MSG_QUEUE, TASK_CLI, TASK_VALVE_DIRECT, TASK_COUNT };
+    // One slot per possible TIME_LSD with the two-second RTC tick.
+    static constexpr uint8_t SLOTS = 30;
+    // Number of recent late loops to keep.
+    static constexpr uint8_t LATE_RING_SIZE = 8;
+    // Loop end times at/above this are recorded as late.
+    static constexpr uint8_t LATE_SCT = OTV0P2BASE::GSCT_MAX - 8;
+    // Recorded as the end time of a loop that overran.
+    static constexpr uint8_t OVERRUN_SCT = 0xff;
+
+  private:
+    // Empty when min > max.
+    struct Stat { uint8_t min, max; uint16_t meanX16; };
+    static void update(Stat &s, uint8_t ticks);
+    static void print(Print &p, const Stat &s);
+    Stat slots[SLOTS];
+    Stat tasks[TASK_COUNT];
+    struct Late { uint8_t tlsd, endSCT; };
+    Late late[LATE_RING_SIZE];
+    uint8_t lateNext;
+
+  public:
+    LoopProfiler() { reset(); }
+    // Clear all results.
+    void reset();
+    // Record ticks spent on the TIME_LSD-specific work of one loop.
+    void recordSlot(const uint_fast8_t tlsd, const uint8_t ticks) { update(slots[(tlsd >> 1) % SLOTS], ticks); }
+    // Record ticks spent in one run of a slow task.
+    void recordTask(const task_t t, const uint8_t ticks) { update(tasks[t], ticks); }
+    // Record where the loop for TIME_LSD ended, noting it if late or overrun.
+    void recordLoopEnd(uint_fast8_t tlsd, uint8_t endSCT, bool overrun);
+    // Dump results to p, stopping early if sub-cycle time reaches stopBy.
+    void dump(Print &p, uint8_t stopBy) const;
+  };
+extern LoopProfiler loopProfiler;
+// Times the enclosing scope as the given task.
+class LoopProfilerTaskTimer final
+  {
+  private:
+    const LoopProfiler::task_t task;
+    const uint8_t start;
+  public:
+    explicit LoopProfilerTaskTimer(const LoopProfiler::task_t t) : task(t), start(OTV0P2BASE::getSubCycleTime()) { }
+    ~LoopProfilerTaskTimer()
+      {
+      const uint8_t end = OTV0P2BASE::getSubCycleTime();
+      // Saturate if the task ran over into the next minor cycle.
+      loopProfiler.recordTask(task, (end >= start) ? (end - start) : 0xff);
+      }
+  };
+#define LOOP_PROFILE_TASK(t) const LoopProfilerTaskTimer _loopProfilerTaskTimer(LoopProfiler::t)
+#else
+#define LOOP_PROFILE_TASK(t) // Not profiling.
+#endif // defined(ENABLE_LOOP_PROFILER)
+
+#if defined(ENABLE_ENERGY_LEDGER)
+// Nominal charge per operation in microcoulombs (uA * s), overridable per board.
+// Defaults are rough figures for REV7 (RFM23B at 1MHz CPU, ~8ms sub-cycle ticks).
+#ifndef ENERGY_UC_TX_FRAME
+#define ENERGY_UC_TX_FRAME 150 // Radio wake, preamble and sync, ~5ms at ~30mA.
+#endif
+#ifndef ENERGY_UC_TX_BYTE
+#define ENERGY_UC_TX_BYTE 5 // ~160us per byte at ~30mA.
+#endif
+#ifndef ENERGY_UC_RX_CYCLE
+#define ENERGY_UC_RX_CYCLE 37000 // Receiver on for a whole 2s minor cycle at ~18.5mA.
+#endif
+#ifndef ENERGY_UC_MOTOR_TICK
+#define ENERGY_UC_MOTOR_TICK 625 // Valve motor running at ~80mA.
+#endif
+#ifndef ENERGY_UC_ADC_READ
+#define ENERGY_UC_ADC_READ 2 // Noise-reduced ADC read with ADC and reference powered.
+#endif
+#ifndef ENERGY_UC_SHT21_TEMP
+#define ENERGY_UC_SHT21_TEMP 25 // 14-bit conversion, ~85ms at ~300uA.
+#endif
+#ifndef ENERGY_UC_SHT21_RH
+#define ENERGY_UC_SHT21_RH 9 // 12-bit conversion, ~29ms at ~300uA.
+#endif
+#ifndef ENERGY_UC_SERIAL_TICK
+#define ENERGY_UC_SERIAL_TICK 4 // UART powered and driving TX at ~0.5mA, over and above E_CPU.
+#endif
+#ifndef ENERGY_UC_CPU_TICK
+#define ENERGY_UC_CPU_TICK 4 // CPU awake at 1MHz at ~0.5mA; CPU_BOOST() charges any extra.
+#endif
+#ifndef ENERGY_UC_SLEEP_CYCLE
+#define ENERGY_UC_SLEEP_CYCLE 4 // ~2uA sleep floor for a whole minor cycle.
+#endif
+
+// Rough energy (charge) ledger, by subsystem.
+// Operations are charged nominal costs as they happen,
+// integrated per hour alongside the by-hour stats updates,
+// so that the battery cost of config choices can be compared in the field.
+// Keeps the last complete hour and the total since reset for each subsystem
+// and the total for each hour of the day, in uAh.
+// Costs ~120 bytes of RAM, so off by default.
+// NOT thread-/ISR- safe; call from the main loop only.
+class EnergyLedger final
+  {
+  public:
+    enum subsystem_t : uint8_t { E_TX, E_RX, E_MOTOR, E_ADC, E_SHT21, E_SERIAL, E_CPU, E_SLEEP, E_COUNT };
+
+  private:
+    // Charge so far this hour, uC.
+    uint32_t thisHourUC[E_COUNT];
+    // Last complete hour, uAh.
+    uint16_t lastHourUAh[E_COUNT];
+    // Since reset, uAh.
+    uint32_t totalUAh[E_COUNT];
+    // All subsystems by hour of day, uAh; 0xffff if not yet known.
+    uint16_t byHourUAh[24];
+
+  public:
+    EnergyLedger() { reset(); }
+    // Clear all results.
+    void reset();
+    // Charge uC to subsystem s.
+    void charge(const subsystem_t s, const uint32_t uC) { thisHourUC[s] += uC; }
+    // Charge one radio TX of len bytes, sent twice if doubleTX.
+    void chargeTX(const uint8_t len, const bool doubleTX = false)
+      { charge(E_TX, (doubleTX ? 2 : 1) * (ENERGY_UC_TX_FRAME + (uint32_t)ENERGY_UC_TX_BYTE * len)); }
+    // Close the current hour (0--23) and start a new one.
+    void endOfHour(uint8_t hour);
+    // Dump results to p, stopping early if sub-cycle time reaches stopBy.
+    void dump(Print &p, uint8_t stopBy) const;
+  };
+extern EnergyLedger energyLedger;
+// Charges the duration of the enclosing scope to a subsystem at ucPerTick.
+class EnergyLedgerTickCharge final
+  {
+  private:
+    const EnergyLedger::subsystem_t subsystem;
+    const uint16_t ucPerTick;
+    const uint8_t start;
+  public:
+    EnergyLedgerTickCharge(const EnergyLedger::subsystem_t s, const uint16_t uc)
+      : subsystem(s), ucPerTick(uc), start(OTV0P2BASE::getSubCycleTime()) { }
+    ~EnergyLedgerTickCharge()
+      {
+      const uint8_t end = OTV0P2BASE::getSubCycleTime();
+      if(end > start) { energyLedger.charge(subsystem, (uint32_t)ucPerTick * (end - start)); }
+      }
+  };
+#define ENERGY_CHARGE(s, uC) energyLedger.charge(EnergyLedger::s, (uC))
+#define ENERGY_CHARGE_TX(len, doubleTX) energyLedger.chargeTX((len), (doubleTX))
+#define ENERGY_CHARGE_TICKS(s, uCPerTick) const EnergyLedgerTickCharge _energyLedgerTickCharge(EnergyLedger::s, (uCPerTick))
+#else
+#define ENERGY_CHARGE(s, uC) // Not accounting.
+#define ENERGY_CHARGE_TX(len, doubleTX) // Not accounting.
+#define ENERGY_CHARGE_TICKS(s, uCPerTick) // Not accounting.
+#endif // defined(ENABLE_ENERGY_LEDGER)
+
+#if defined(ENABLE_CPU_BOOST)
+#include <avr/power.h>
+// Lowest supply reading for 8MHz, else the boost is to 4MHz, which is safe down to 1.8V.
+// The ATmega328P safe operating area runs from 4MHz at 1.8V to 10MHz at 2.7V,
+// so 8MHz needs 2.4V, right on the line; Supply_cV is an unloaded reading
+// up to a minute old and the supply sags under radio TX, so allow 0.3V for that.
+#ifndef CPU_BOOST_8MHZ_MIN_CV
+#define CPU_BOOST_8MHZ_MIN_CV 270
+#endif
+// Nominal CPU charge per ~8ms sub-cycle tick awake at each clock, for the benchmark.
+#ifndef CPU_BOOST_UC_TICK_1MHZ
+#define CPU_BOOST_UC_TICK_1MHZ 4 // ~0.5mA.
+#endif
+#ifndef CPU_BOOST_UC_TICK_4MHZ
+#define CPU_BOOST_UC_TICK_4MHZ 14 // ~1.8mA.
+#endif
+#ifndef CPU_BOOST_UC_TICK_8MHZ
+#define CPU_BOOST_UC_TICK_8MHZ 23 // ~3mA.
+#endif
+// Scoped CPU clock boost from the normal 1MHz (8MHz RC / 8) for CPU-bound work
+// such as crypto, frame building and CRCs, so as to get back to sleep sooner.
+// Serial is flushed either side and its baud divisor rescaled, so Serial stays usable.
+// Sub-cycle time runs from the 32768Hz crystal so is unaffected.
+// Must NOT enclose anything timed from the CPU clock:
+// delay()/millis(), bit-banged I/O (eg OneWire, soft serial to a SIM900),
+// or I2C sensor reads (SCL would go out of spec).
+// SPI is fine (at most 4MHz); nested boosts do nothing.
+// With ENABLE_ENERGY_LEDGER, the extra CPU charge over 1MHz for the boosted ticks goes to E_CPU.
+class CPUBoost final
+  {
+  private:
+    const clock_div_t saved;
+    // Clock multiple while boosted; 1 if not boosted.
+    uint8_t factor;
+    uint16_t savedUBRR;
+#if defined(ENABLE_ENERGY_LEDGER)
+    // Sub-cycle time when boosted.
+    uint8_t startSCT;
+#endif
+  public:
+    CPUBoost();
+    ~CPUBoost();
+    uint8_t getFactor() const { return(factor); }
+  };
+#define CPU_BOOST() const CPUBoost _cpuBoost
+// Time some secure frame encryptions at 1MHz then boosted, and print the results.
+void benchmarkCPUBoost(Print &p);
+#else
+#define CPU_BOOST() // Not boosting.
+#endif // defined(ENABLE_CPU_BOOST)
+
+#if defined(ENABLE_RX_ASSOC_PREFILTER)
+// Reload the RX ISR's RAM copy of the node association table; call after any change to it.
+void rebuildRXAssocPrefilter();
+#endif // defined(ENABLE_RX_ASSOC_PREFILTER)
+
+#if defined(ENABLE_RX_CAPTURE)
+#include "RXCapture.h"
+// Bytes of RX capture records buffered between the RX ISR and the main loop.
+#ifndef RX_CAPTURE_RING_BYTES
+#define RX_CAPTURE_RING_BYTES 160
+#endif
+// Every frame offered to the primary radio RX queue, with the RX filter verdict.
+extern RXCaptureRing<RX_CAPTURE_RING_BYTES> rxCapture;
+#endif // defined(ENABLE_RX_CAPTURE)
+
+
 ////////////////////////// Actuators
 
 // DORM1/REV7 direct drive motor actuator.
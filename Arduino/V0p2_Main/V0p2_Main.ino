@@ -248,6 +248,92 @@ static bool FilterRXISR(const volatile uint8_t *buf, volatile uint8_t &buflen)
 #define FilterRXISR NULL
 #endif
 
+#if defined(ENABLE_RX_ASSOC_PREFILTER)
+// RAM copy of the leading 4 ID bytes of each associated node ('A' CLI command),
+// as big-endian values sorted ascending so that the RX ISR can binary-search it.
+// Entries sharing a prefix are contiguous, so short on-air IDs match a range.
+static uint32_t rxAssocIDs[V0P2BASE_EE_NODE_ASSOCIATIONS_MAX_SETS];
+static uint8_t rxAssocCount;
+void rebuildRXAssocPrefilter()
+  {
+  uint32_t ids[V0P2BASE_EE_NODE_ASSOCIATIONS_MAX_SETS];
+  uint8_t n = 0;
+  uint8_t nodeID[OTV0P2BASE::OpenTRV_Node_ID_Bytes];
+  for(int8_t i = 0; (n < V0P2BASE_EE_NODE_ASSOCIATIONS_MAX_SETS) && ((i = OTV0P2BASE::getNextMatchingNodeID(i, NULL, 0, nodeID)) >= 0); ++i)
+    {
+    uint32_t id = ((uint32_t)nodeID[0] << 24) | ((uint32_t)nodeID[1] << 16) | ((uint16_t)nodeID[2] << 8) | nodeID[3];
+    // Insertion sort: tiny table, rebuilt rarely.
+    uint8_t j = n++;
+    for( ; (j > 0) && (ids[j-1] > id); --j) { ids[j] = ids[j-1]; }
+    ids[j] = id;
+    }
+  ATOMIC_BLOCK (ATOMIC_RESTORESTATE)
+    {
+    memcpy(rxAssocIDs, ids, n * sizeof(ids[0]));
+    rxAssocCount = n;
+    }
+  }
+// True if t is a secureable frame type with the secure bit set.
+// FS20 (0xcc) frames also have the high bit set but carry no ID, so must never be ID-checked.
+static inline bool isSecureFrameTypeISR(const uint8_t t)
+  {
+  return((0 != (t & 0x80)) && (OTRadioLink::FTp2_FS20_native != t) &&
+         ((t & 0x7f) > OTRadioLink::FTS_NONE) && ((t & 0x7f) < OTRadioLink::FTS_INVALID_HIGH));
+  }
+// Filter applied first: drops secure frames from nodes not in the association table,
+// so they are neither queued nor decrypted; everything else goes on to the normal FilterRXISR.
+// Assumes the queued secure frame starts with the frame type (high bit set),
+// then the sequence number / ID length byte, then the ID.
+// With no associations set, all frames are passed on (as before).
+static bool (*const assocFilteredRXISR)(const volatile uint8_t *buf, volatile uint8_t &buflen) = FilterRXISR;
+static bool AssocFilterRXISR(const volatile uint8_t *buf, volatile uint8_t &buflen)
+  {
+  const uint8_t n = rxAssocCount;
+  if((0 != n) && (buflen >= 2) && isSecureFrameTypeISR(buf[0]))
+    {
+    const uint8_t il = buf[1] & 0xf;
+    if(buflen < 2 + il) { return(false); }
+    const uint8_t cmpBytes = (il < 4) ? il : 4;
+    if(0 != cmpBytes)
+      {
+      // Compare on the on-air ID bytes only.
+      const uint32_t mask = ~(uint32_t)0 << (8 * (4 - cmpBytes));
+      uint32_t id = 0;
+      for(uint8_t i = 0; i < cmpBytes; ++i) { id |= (uint32_t)buf[2 + i] << (8 * (3 - i)); }
+      uint8_t lo = 0, hi = n;
+      while(lo < hi)
+        {
+        const uint8_t mid = (lo + hi) >> 1;
+        if((rxAssocIDs[mid] & mask) < id) { lo = mid + 1; } else { hi = mid; }
+        }
+      if((lo >= n) || ((rxAssocIDs[lo] & mask) != id)) { return(false); }
+      }
+    }
+  return((NULL == assocFilteredRXISR) || assocFilteredRXISR(buf, buflen));
+  }
+#undef FilterRXISR
+#undef NO_RX_FILTER
+#define FilterRXISR AssocFilterRXISR
+#endif // defined(ENABLE_RX_ASSOC_PREFILTER)
+
+#if defined(ENABLE_RX_CAPTURE)
+RXCaptureRing<RX_CAPTURE_RING_BYTES> rxCapture;
+// Filter actually installed: records each frame and the verdict of the normal FilterRXISR, if any.
+static bool (*const capturedFilterRXISR)(const volatile uint8_t *buf, volatile uint8_t &buflen) = FilterRXISR;
+static bool CaptureFilterRXISR(const volatile uint8_t *buf, volatile uint8_t &buflen)
+  {
+  const uint8_t rawLen = buflen;
+  const bool accepted = (NULL == capturedFilterRXISR) || capturedFilterRXISR(buf, buflen);
+  // RSSI is not available through OTRadioLink so is recorded as 0 (see RXCapture.h).
+  rxCapture.recordISR(buf, rawLen, accepted ? buflen : 0, accepted, 0,
+                      OTV0P2BASE::getMinutesSinceMidnightLT(), OTV0P2BASE::getSecondsLT(), OTV0P2BASE::getSubCycleTime());
+  return(accepted);
+  }
+#undef FilterRXISR
+#undef NO_RX_FILTER
+#define FilterRXISR CaptureFilterRXISR
+#endif // defined(ENABLE_RX_CAPTURE)
+
 void optionalPOST()
   {
   // Have 32678Hz clock at least running before going any further.
@@ -289,6 +375,9 @@ void optionalPOST()
   // Check that the radio is correctly connected; panic if not...
   if(!PrimaryRadio.configure(nPrimaryRadioChannels, RFM23BConfigs) || !PrimaryRadio.begin()) { panic(F("r1")); }
   // Apply filtering, if any, while we're having fun...
+#if defined(ENABLE_RX_ASSOC_PREFILTER)
+  rebuildRXAssocPrefilter();
+#endif
 #ifndef NO_RX_FILTER
   PrimaryRadio.setFilterRXISR(FilterRXISR);
 #endif // NO_RX_FILTER
@@ -367,14 +456,19 @@ OTV0P2BASE::DummyHumiditySensorSHT21 RelHumidity;
 
 // Ambient/room temperature sensor, usually on main board.
 #if defined(ENABLE_PRIMARY_TEMP_SENSOR_SHT21)
-OTV0P2BASE::RoomTemperatureC16_SHT21 TemperatureC16; // SHT21 impl.
+TemperatureC16_t TemperatureC16; // SHT21 impl.
 #elif defined(ENABLE_PRIMARY_TEMP_SENSOR_DS18B20)
 #if defined(ENABLE_MINIMAL_ONEWIRE_SUPPORT)
+#if defined(ENABLE_ASYNC_TEMP_SENSOR)
+// DSB18B20 temperature impl at full precision: the ~750ms conversion overlaps sleep.
+TemperatureC16_t TemperatureC16(MinOW_DEFAULT, OTV0P2BASE::TemperatureC16_DS18B20::MAX_PRECISION);
+#else
 // DSB18B20 temperature impl, with slightly reduced precision to improve speed.
-OTV0P2BASE::TemperatureC16_DS18B20 TemperatureC16(MinOW_DEFAULT, OTV0P2BASE::TemperatureC16_DS18B20::MAX_PRECISION - 1);
+TemperatureC16_t TemperatureC16(MinOW_DEFAULT, OTV0P2BASE::TemperatureC16_DS18B20::MAX_PRECISION - 1);
+#endif
 #endif
 #else // Don't use TMP112 if SHT21 or DS18B20 are selected.
-OTV0P2BASE::RoomTemperatureC16_TMP112 TemperatureC16;
+TemperatureC16_t TemperatureC16;
 #endif
 
 #ifdef ENABLE_VOICE_SENSOR
@@ -421,7 +515,7 @@ uint8_t *appendStatsToTXBufferWithFF(uint8_t *bptr, const uint8_t bufSize)
 #endif
   {
     // Assume enough space in buffer for largest possible stats message.
-    bptr = OTV0P2BASE::encodeFullStatsMessageCore(bptr, bufSize, OTV0P2BASE::getStatsTXLevel(), false, &trailer);
+    bptr = OTV0P2BASE::encodeFullStatsMessageCore(bptr, bufSize, getStatsTXLevelFast(), false, &trailer);
   }
   return (bptr);
 }
@@ -477,7 +571,10 @@ OTRadioLink::OTNullRadioLink NullRadio;
 
 // Brings in necessary radio libs.
 #ifdef ENABLE_RADIO_RFM23B
-#if defined(ENABLE_TRIMMED_MEMORY) && !defined(ENABLE_DEFAULT_ALWAYS_RX) && !defined(ENABLE_CONTINUOUS_RX)
+#if defined(RX_QUEUE_CAPACITY)
+// Depth set explicitly for this config, eg deeper for a busy hub.
+static constexpr uint8_t RFM23B_RX_QUEUE_SIZE = RX_QUEUE_CAPACITY;
+#elif defined(ENABLE_TRIMMED_MEMORY) && !defined(ENABLE_DEFAULT_ALWAYS_RX) && !defined(ENABLE_CONTINUOUS_RX)
 static constexpr uint8_t RFM23B_RX_QUEUE_SIZE = OTV0P2BASE::fnmax(uint8_t(2), uint8_t(OTRFM23BLink::DEFAULT_RFM23B_RX_QUEUE_CAPACITY)) - 1;
 #else
 static constexpr uint8_t RFM23B_RX_QUEUE_SIZE = OTRFM23BLink::DEFAULT_RFM23B_RX_QUEUE_CAPACITY;
@@ -535,17 +632,15 @@ OTRadioLink::OTRadioLink &SecondaryRadio = NullRadio;
 // - Just boiler hub (e.g. CONFIG_REV8_SECURE_BHR)
 // - Unit acting as stats-hub (e.g. CONFIG_REV11_SECURE_STATSHUB)
 
-// Workspace for running the decode routine within.
-// FIXME workspaceRequiredDec seems to be 16 bytes too small. 58 bytes are for the SecureFrameImpl chain.
-constexpr size_t decodeWorkspaceSize = OTAESGCM::OTAES128GCMGenericWithWorkspace<>::workspaceRequiredDec + 58 + 16;
+// Workspace for running the decode routine within is WS_DECODE in the shared workspace.
 #if defined(ENABLE_RADIO_SECONDARY_SIM900) && defined(ENABLE_RADIO_SECONDARY_MODULE_AS_RELAY) && defined(ENABLE_BOILER_HUB)
 // relay + bh
 inline bool decodeAndHandleSecureFrame(volatile const uint8_t * const msg)
 {
-    uint8_t workspace[decodeWorkspaceSize];
-    OTV0P2BASE::ScratchSpaceL sW(workspace, sizeof(workspace));
+    WORKSPACE_CLAIM(WS_DECODE);
+    OTV0P2BASE::ScratchSpaceL sW(workspaceFor<WS_DECODE>(), WorkspacePlan::size(WS_DECODE));
   return OTRadioLink::decodeAndHandleOTSecureOFrameWithWorkspace<OTRadioLink::SimpleSecureFrame32or0BodyRXV0p2,
-                                                    OTAESGCM::fixed32BTextSize12BNonce16BTagSimpleDec_DEFAULT_WITH_LWORKSPACE,
+                                                    AESGCM_DEC_WITH_LWORKSPACE,
                                                    OTV0P2BASE::getPrimaryBuilding16ByteSecretKey,
                                                    OTRadioLink::relayFrameOperation<decltype(SIM900), SIM900>,
                                                    OTRadioLink::boilerFrameOperation<decltype(BoilerHub), BoilerHub, minuteCount>
@@ -555,10 +650,10 @@ inline bool decodeAndHandleSecureFrame(volatile const uint8_t * const msg)
 // relay
 inline bool decodeAndHandleSecureFrame(volatile const uint8_t * const msg)
 {
-    uint8_t workspace[decodeWorkspaceSize];
-    OTV0P2BASE::ScratchSpaceL sW(workspace, sizeof(workspace));
+    WORKSPACE_CLAIM(WS_DECODE);
+    OTV0P2BASE::ScratchSpaceL sW(workspaceFor<WS_DECODE>(), WorkspacePlan::size(WS_DECODE));
   return OTRadioLink::decodeAndHandleOTSecureOFrameWithWorkspace<OTRadioLink::SimpleSecureFrame32or0BodyRXV0p2,
-                                                    OTAESGCM::fixed32BTextSize12BNonce16BTagSimpleDec_DEFAULT_WITH_LWORKSPACE,
+                                                    AESGCM_DEC_WITH_LWORKSPACE,
                                                    OTV0P2BASE::getPrimaryBuilding16ByteSecretKey,
                                                    OTRadioLink::relayFrameOperation<decltype(SIM900), SIM900>
                                                   >(msg, sW);
@@ -567,10 +662,11 @@ inline bool decodeAndHandleSecureFrame(volatile const uint8_t * const msg)
 // bh
 inline bool decodeAndHandleSecureFrame(volatile const uint8_t * const msg)
 {
-    uint8_t workspace[decodeWorkspaceSize];
-    OTV0P2BASE::ScratchSpaceL sW(workspace, sizeof(workspace));
+    CPU_BOOST(); // No bit-banged relay I/O in this configuration.
+    WORKSPACE_CLAIM(WS_DECODE);
+    OTV0P2BASE::ScratchSpaceL sW(workspaceFor<WS_DECODE>(), WorkspacePlan::size(WS_DECODE));
   return OTRadioLink::decodeAndHandleOTSecureOFrameWithWorkspace<OTRadioLink::SimpleSecureFrame32or0BodyRXV0p2,
-                                                    OTAESGCM::fixed32BTextSize12BNonce16BTagSimpleDec_DEFAULT_WITH_LWORKSPACE,
+                                                    AESGCM_DEC_WITH_LWORKSPACE,
                                                    OTV0P2BASE::getPrimaryBuilding16ByteSecretKey,
                                                    OTRadioLink::boilerFrameOperation<decltype(BoilerHub), BoilerHub, minuteCount>
                                                   >(msg, sW);
@@ -579,10 +675,11 @@ inline bool decodeAndHandleSecureFrame(volatile const uint8_t * const msg)
 // serial
 inline bool decodeAndHandleSecureFrame(volatile const uint8_t * const msg)
 {
-    uint8_t workspace[decodeWorkspaceSize];
-    OTV0P2BASE::ScratchSpaceL sW(workspace, sizeof(workspace));
+    CPU_BOOST(); // No bit-banged relay I/O in this configuration.
+    WORKSPACE_CLAIM(WS_DECODE);
+    OTV0P2BASE::ScratchSpaceL sW(workspaceFor<WS_DECODE>(), WorkspacePlan::size(WS_DECODE));
   return OTRadioLink::decodeAndHandleOTSecureOFrameWithWorkspace<OTRadioLink::SimpleSecureFrame32or0BodyRXV0p2,
-                                                    OTAESGCM::fixed32BTextSize12BNonce16BTagSimpleDec_DEFAULT_WITH_LWORKSPACE,
+                                                    AESGCM_DEC_WITH_LWORKSPACE,
                                                    OTV0P2BASE::getPrimaryBuilding16ByteSecretKey,
                                                    OTRadioLink::serialFrameOperation<decltype(Serial), Serial>
                                                   >(msg, sW);
@@ -671,6 +768,11 @@ void setup()
 #endif
 #endif
 
+#if defined(ENABLE_CONFIG_CACHE)
+  // Before anything that may read the config.
+  configCache.reload();
+#endif
+
   optionalPOST();
 
   // Collect full set of environmental values before entering loop() in normal mode.
@@ -746,6 +848,10 @@ void setup()
     if(!OTV0P2BASE::ensureIDCreated(true)) // Force reset.
       { panic(F("ID")); }
     }
+#if defined(ENABLE_CONFIG_CACHE)
+  // Pick up any node ID just created or reset, else the cache holds the old or erased one.
+  configCache.reload();
+#endif
 
   // Initialised: turn main/heatcall UI LED off.
   OTV0P2BASE::LED_HEATCALL_OFF();
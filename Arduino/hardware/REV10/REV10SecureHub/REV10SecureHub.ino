@@ -63,6 +63,15 @@ Author(s) / Copyright (s): Damon Hart-Davis 2013--2017
 #undef V0P2_DEBUG_NO_STATSTX
 // If defined, disable own stats encryption and tx.
 #undef V0P2_DEBUG_NO_STATSENC
+// If defined, copy RXed frames out to a larger RAM ring and decrypt them in batches
+// with radio interrupts left running, rather than one at a time with RX paused.
+// EXPERIMENTAL: costs ~270 bytes more RAM, and RX interrupts may nest on the stack
+// during a decrypt; only enable after checking 'S' stack headroom (SH) under heavy RX.
+#undef ENABLE_HUB_BATCHED_DECODE
+// If defined, also pass authenticated frames to BoilerHub,
+// and switch the boiler on as soon as a call for heat is heard
+// rather than at the start of the next minor cycle.
+#undef ENABLE_FAST_CALL_FOR_HEAT
 
 
 // *** Global flag for REVx configuration here *** //
@@ -362,11 +371,88 @@ inline bool decodeAndHandleSecureFrame(volatile const uint8_t * const msg)
             OTAESGCM::fixed32BTextSize12BNonce16BTagSimpleDec_DEFAULT_WITH_LWORKSPACE,      // auth/decrypt with AES128GCM fixed frame size, using the workspace.
             OTV0P2BASE::getPrimaryBuilding16ByteSecretKey,                                  // Decode with the primary building secret key.
             OTRadioLink::serialFrameOperation<decltype(Serial), Serial>     // Relay the frame if it passes auth.
+#if defined(ENABLE_FAST_CALL_FOR_HEAT)
+          , OTRadioLink::boilerFrameOperation<decltype(BoilerHub), BoilerHub, minuteCount>  // And act on any call for heat.
+#endif
         >(msg, sW);
     // Reenable interrupt line.
     PrimaryRadio.pauseInterrupts(false);
     return (success);
 }
+#if defined(ENABLE_HUB_BATCHED_DECODE) && !defined(V0P2_DEBUG_NO_MESSAGE_QUEUE)
+/**
+ * @brief   Batched decode pipeline.
+ *          Frames are moved out of the (small) radio RX queue into hubRXRing
+ *          before and after each decrypt, so the RX ISR nearly always has room,
+ *          and the whole batch is decrypted in the one shared globalWorkSpace.decode.
+ *          Radio interrupts are NOT paused during the decrypt:
+ *          the AES-GCM workspace is static, so the ISR only nests its own modest frame
+ *          on the stack (check the minimum stack headroom shown by CLI 'S' under load).
+ *          The ISR still only fills the radio RX queue during a decrypt;
+ *          frames are moved to the ring between decrypts.
+ *          Not measured on hardware for RAM or stack headroom: off by default.
+ */
+static constexpr uint8_t HUB_RX_RING_FRAMES = 4;
+static constexpr uint8_t HUB_RX_MAX_FRAME = 64;
+// Each slot is the frame length then the frame, as in the radio RX queue.
+static uint8_t hubRXRing[HUB_RX_RING_FRAMES][1 + HUB_RX_MAX_FRAME];
+static uint8_t hubRXHead, hubRXCount;
+// Counters for CLI 'S'; wrap.
+static struct {
+    uint16_t queued;    // Frames moved into the ring.
+    uint16_t decoded;   // Frames decode was attempted on.
+    uint16_t ok;        // Frames that authenticated and were handled.
+    uint16_t oversize;  // Frames too long for a ring slot, discarded.
+    uint8_t maxDepth;   // Highest ring occupancy seen.
+} hubRXStats;
+
+// Move as many frames as fit from the radio RX queue into the ring.
+static void drainRadioRXQueue()
+{
+    for(const volatile uint8_t *msg; (hubRXCount < HUB_RX_RING_FRAMES) && (NULL != (msg = PrimaryRadio.peekRXMsg())); ) {
+        const uint8_t len = msg[-1];
+        if(len <= HUB_RX_MAX_FRAME) {
+            uint8_t *const slot = hubRXRing[(hubRXHead + hubRXCount) % HUB_RX_RING_FRAMES];
+            slot[0] = len;
+            for(uint8_t i = 0; i < len; ++i) { slot[1 + i] = msg[i]; }
+            ++hubRXStats.queued;
+            if(++hubRXCount > hubRXStats.maxDepth) { hubRXStats.maxDepth = hubRXCount; }
+        } else { ++hubRXStats.oversize; }
+        PrimaryRadio.removeRXMsg();
+    }
+}
+
+// Decrypt and handle queued frames until the ring is empty or the minor cycle is getting full.
+// Returns true if any work was done.
+static bool decodeHubRXBatch()
+{
+    pollIO();
+    drainRadioRXQueue();
+    if(0 == hubRXCount) { return(false); }
+    OTV0P2BASE::ScratchSpaceL sW(globalWorkSpace.decode, sizeof(globalWorkSpace.decode));
+    while(hubRXCount > 0) {
+        const uint8_t *const frame = hubRXRing[hubRXHead] + 1;
+        ++hubRXStats.decoded;
+        if(OTRadioLink::decodeAndHandleOTSecureOFrame<
+                OTRadioLink::SimpleSecureFrame32or0BodyRXV0p2,
+                OTAESGCM::fixed32BTextSize12BNonce16BTagSimpleDec_DEFAULT_WITH_LWORKSPACE,
+                OTV0P2BASE::getPrimaryBuilding16ByteSecretKey,
+                OTRadioLink::serialFrameOperation<decltype(Serial), Serial>
+#if defined(ENABLE_FAST_CALL_FOR_HEAT)
+              , OTRadioLink::boilerFrameOperation<decltype(BoilerHub), BoilerHub, minuteCount>
+#endif
+            >(frame, sW)) { ++hubRXStats.ok; }
+        hubRXHead = (hubRXHead + 1) % HUB_RX_RING_FRAMES;
+        --hubRXCount;
+        // Take in anything that arrived during the decrypt before starting the next.
+        pollIO();
+        drainRadioRXQueue();
+        // Leave the rest for the next pass rather than risk an overrun.
+        if(OTV0P2BASE::getSubCycleTime() >= OTV0P2BASE::GSCT_MAX - 16) { break; }
+    }
+    return(true);
+}
+#endif // defined(ENABLE_HUB_BATCHED_DECODE) && !defined(V0P2_DEBUG_NO_MESSAGE_QUEUE)
 #ifndef V0P2_DEBUG_NO_MESSAGE_QUEUE
 OTRadioLink::OTMessageQueueHandler< pollIO, V0P2_UART_BAUD,
                                     decodeAndHandleSecureFrame, OTRadioLink::decodeAndHandleDummyFrame  // only interested in single frame type.
@@ -376,6 +462,25 @@ OTRadioLink::OTMessageQueueHandlerNull messageQueue;
 #endif
 
 
+// Process any received frames.
+static bool handleRX()
+{
+#if defined(ENABLE_FAST_CALL_FOR_HEAT)
+    const bool wasOn = BoilerHub.isBoilerOn();
+#endif
+#if defined(ENABLE_HUB_BATCHED_DECODE) && !defined(V0P2_DEBUG_NO_MESSAGE_QUEUE)
+    const bool handled = decodeHubRXBatch();
+#else
+    const bool handled = messageQueue.handle(true, PrimaryRadio);
+#endif
+#if defined(ENABLE_FAST_CALL_FOR_HEAT)
+    // Let the boiler logic update its output now rather than at the start of the next minor cycle;
+    // not a new second, so no timers are aged.
+    if(!wasOn && BoilerHub.isBoilerOn()) { BoilerHub.processCallsForHeat(false, hubManager.inHubMode()); }
+#endif
+    return(handled);
+}
+
 // Poll I/O and process message incrementally (in this otherwise idle time)
 // before sleep and on wakeup in case some IO needs further processing now,
 // eg work was accrued during the previous major slow/outer loop
@@ -385,7 +490,7 @@ OTRadioLink::OTMessageQueueHandlerNull messageQueue;
 bool preSleepIO()
 {
     pollIO();
-    return (messageQueue.handle(true, PrimaryRadio));
+    return (handleRX());
 }
 
 
@@ -568,6 +673,18 @@ void pollCLI(const uint8_t maxSCT, const bool startOfMinute, const OTV0P2BASE::S
                 Serial.print(F("Resets: "));
                 Serial.print(resetCount);
                 Serial.println();
+#if defined(ENABLE_HUB_BATCHED_DECODE) && !defined(V0P2_DEBUG_NO_MESSAGE_QUEUE)
+                // RX pipeline: queued/decoded/ok/oversize frames, max ring depth, radio queue drops, min stack headroom.
+                Serial.print(F("RX q/d/ok/big "));
+                Serial.print(hubRXStats.queued); Serial.print('/');
+                Serial.print(hubRXStats.decoded); Serial.print('/');
+                Serial.print(hubRXStats.ok); Serial.print('/');
+                Serial.print(hubRXStats.oversize);
+                Serial.print(F(" max ")); Serial.print(hubRXStats.maxDepth);
+                Serial.print(F(" drop ")); Serial.print(PrimaryRadio.getRXMsgsDroppedRecent());
+                Serial.print(F(" SH ")); Serial.print(OTV0P2BASE::MemoryChecks::getMinSPSpaceBelowStackToEnd());
+                Serial.println();
+#endif
 #if 0
                 // Show stack headroom.
                 OTV0P2BASE::serialPrintAndFlush(F("SH ")); OTV0P2BASE::serialPrintAndFlush(OTV0P2BASE::MemoryChecks::getMinSPSpaceBelowStackToEnd()); OTV0P2BASE::serialPrintlnAndFlush();
@@ -765,7 +882,7 @@ void loop()
 
     // Handling the UI may have taken a little while, so process I/O a little.
     pollIO(); // Deal with any pending I/O.
-    messageQueue.handle(true, PrimaryRadio); // Deal with any pending I/O.
+    handleRX(); // Deal with any pending I/O.
 
     // DO SCHEDULING
 
@@ -866,7 +983,7 @@ void loop()
     // End-of-loop processing, that may be slow.
     // Ensure progress on queued messages ahead of slow work.  (TODO-867)
     pollIO();; // Deal with any pending I/O.
-    messageQueue.handle(true, PrimaryRadio); // Deal with any pending I/O.
+    handleRX(); // Deal with any pending I/O.
 
     // Command-Line Interface (CLI) polling.
     // If a reasonable chunk of the minor cycle remains after all other work is done
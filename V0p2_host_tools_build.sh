@@ -0,0 +1,42 @@
+#!/bin/sh -e
+#
+# Build the standalone host tools for V0p2_Main.
+#
+# Usage: ./V0p2_host_tools_build.sh
+#
+# Builds the RXCapture_Extract tool
+# and builds and runs the AESGCMContext_Test check;
+# these need no libraries, only a host C++ compiler,
+# and leave their executables in the current directory.
+#
+# See util/V0p2_host/README.txt for what they do.
+
+# Host C++ compiler.
+CXX=${CXX:-g++}
+
+# RX capture extractor/lister: standalone, needs only the sketch header.
+$CXX -std=gnu++11 -O2 -Wall -o $PWD/RXCapture_Extract $PWD/util/V0p2_host/RXCapture/RXCapture_Extract.cpp
+echo Built $PWD/RXCapture_Extract
+
+# Cached AES-GCM context (ENABLE_CACHED_AESGCM_CONTEXT) against the GCM spec test vectors: standalone.
+$CXX -std=gnu++11 -O2 -Wall -o $PWD/AESGCMContext_Test $PWD/util/V0p2_host/AESGCM/AESGCMContext_Test.cpp
+$PWD/AESGCMContext_Test
+
+# *************************************************************
+#
+# The OpenTRV project licenses this file to you
+# under the Apache Licence, Version 2.0 (the "Licence");
+# you may not use this file except in compliance
+# with the Licence. You may obtain a copy of the Licence at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the Licence is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied. See the Licence for the
+# specific language governing permissions and limitations
+# under the Licence.
+#
+# *************************************************************
+# Author(s) / Copyright (s): Damon Hart-Davis 2017
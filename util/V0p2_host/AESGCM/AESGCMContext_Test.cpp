@@ -0,0 +1,124 @@
+/*
+The OpenTRV project licenses this file to you
+under the Apache Licence, Version 2.0 (the "Licence");
+you may not use this file except in compliance
+with the Licence. You may obtain a copy of the Licence at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the Licence is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied. See the Licence for the
+specific language governing permissions and limitations
+under the Licence.
+
+Author(s) / Copyright (s): Damon Hart-Davis 2017
+*/
+
+/*
+ Host-side check of the sketch's cached AES-128-GCM context
+ (see Arduino/V0p2_Main/AESGCMContext.h, ENABLE_CACHED_AESGCM_CONTEXT)
+ against the AES-128 / 96-bit IV test cases 1--4 from McGrew and Viega,
+ "The Galois/Counter Mode of Operation (GCM)",
+ with and without the GHASH table, in both directions,
+ plus tag rejection and switching between keys.
+
+ Prints one line per failure and exits non-zero if any.
+
+ Build: g++ -std=gnu++11 -O2 -Wall -o AESGCMContext_Test AESGCMContext_Test.cpp
+ */
+
+#include <stdio.h>
+
+#include "../../../Arduino/V0p2_Main/AESGCMContext.h"
+
+// Parse the hex string into buf; returns byte count.
+static uint8_t fromHex(const char *hex, uint8_t *const buf)
+  {
+  uint8_t n = 0;
+  for( ; ('\0' != hex[0]) && ('\0' != hex[1]); hex += 2)
+    {
+    unsigned b;
+    sscanf(hex, "%2x", &b);
+    buf[n++] = (uint8_t)b;
+    }
+  return(n);
+  }
+
+struct TestCase
+  {
+  const char *name, *key, *iv, *aad, *plain, *cipher, *tag;
+  };
+
+static const char K0[] = "00000000000000000000000000000000";
+static const char K3[] = "feffe9928665731c6d6a8f9467308308";
+static const char IV0[] = "000000000000000000000000";
+static const char IV3[] = "cafebabefacedbaddecaf888";
+static const TestCase testCases[] =
+  {
+  { "TC1", K0, IV0, "", "", "", "58e2fccefa7e3061367f1d57a4e7455a" },
+  { "TC2", K0, IV0, "", "00000000000000000000000000000000",
+    "0388dace60b6a392f328c2b971b2fe78", "ab6e47d42cec13bdf53a67b21257bddf" },
+  { "TC3", K3, IV3, "",
+    "d9313225f88406e5a55909c5aff5269a86a7a9531534f7da2e4c303d8a318a72"
+    "1c3c0c95956809532fcf0e2449a6b525b16aedf5aa0de657ba637b391aafd255",
+    "42831ec2217774244b7221b784d0d49ce3aa212f2c02a4e035c17e2329aca12e"
+    "21d514b25466931c7d8f6a5aac84aa051ba30b396a0aac973d58e091473f5985",
+    "4d5c2af327cd64a62cf35abd2ba6fab4" },
+  { "TC4", K3, IV3, "feedfacedeadbeeffeedfacedeadbeefabaddad2",
+    "d9313225f88406e5a55909c5aff5269a86a7a9531534f7da2e4c303d8a318a72"
+    "1c3c0c95956809532fcf0e2449a6b525b16aedf5aa0de657ba637b39",
+    "42831ec2217774244b7221b784d0d49ce3aa212f2c02a4e035c17e2329aca12e"
+    "21d514b25466931c7d8f6a5aac84aa051ba30b396a0aac973d58e091",
+    "5bc94fbc3221a5db94fae95ae7121a47" },
+  };
+
+static int failures;
+static void check(const bool ok, const char *const name, const char *const what, const bool table)
+  {
+  if(ok) { return; }
+  printf("FAIL %s %s%s\n", name, what, table ? " (table)" : "");
+  ++failures;
+  }
+
+template <bool GHASH_TABLE>
+static void runAll()
+  {
+  AES128GCMContext<GHASH_TABLE> ctx;
+  // Run twice, so that the second pass reuses a cached key after switching back from another.
+  for(int pass = 0; pass < 2; ++pass)
+    {
+    for(const TestCase &tc : testCases)
+      {
+      uint8_t key[16], iv[12], aad[32], plain[64], cipher[64], tag[16];
+      fromHex(tc.key, key);
+      fromHex(tc.iv, iv);
+      const uint8_t aadLen = fromHex(tc.aad, aad);
+      const uint8_t len = fromHex(tc.plain, plain);
+      fromHex(tc.cipher, cipher);
+      fromHex(tc.tag, tag);
+      ctx.setKey(key);
+
+      uint8_t out[64], outTag[16];
+      ctx.encrypt(iv, aad, aadLen, plain, len, out, outTag);
+      check(0 == memcmp(out, cipher, len), tc.name, "cipher-text", GHASH_TABLE);
+      check(0 == memcmp(outTag, tag, 16), tc.name, "encrypt tag", GHASH_TABLE);
+
+      check(ctx.decrypt(iv, aad, aadLen, cipher, len, tag, out), tc.name, "decrypt rejected", GHASH_TABLE);
+      check(0 == memcmp(out, plain, len), tc.name, "plain-text", GHASH_TABLE);
+
+      tag[15] ^= 1;
+      check(!ctx.decrypt(iv, aad, aadLen, cipher, len, tag, out), tc.name, "bad tag accepted", GHASH_TABLE);
+      }
+    }
+  ctx.clear();
+  }
+
+int main()
+  {
+  runAll<false>();
+  runAll<true>();
+  if(0 == failures) { printf("OK\n"); }
+  return((0 == failures) ? 0 : 1);
+  }
@@ -0,0 +1,90 @@
+/*
+The OpenTRV project licenses this file to you
+under the Apache Licence, Version 2.0 (the "Licence");
+you may not use this file except in compliance
+with the Licence. You may obtain a copy of the Licence at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the Licence is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied. See the Licence for the
+specific language governing permissions and limitations
+under the Licence.
+
+Author(s) / Copyright (s): Damon Hart-Davis 2017
+*/
+
+/*
+ RX capture tool (see Arduino/V0p2_Main/RXCapture.h).
+
+ Usage: RXCapture_Extract < serial.log > capture.rxc
+        RXCapture_Extract -l < capture.rxc
+
+ With no option, picks the '%' record lines out of a hub's ENABLE_RX_CAPTURE
+ Serial log (other lines are ignored) and writes a binary capture.
+ Captures can simply be concatenated.
+ With -l, lists a binary capture one record per line:
+     hh:mm:ss.sct  raw=<n> kept=<n> [lost] <hex frame>
+
+ Build: g++ -std=gnu++11 -O2 -o RXCapture_Extract RXCapture_Extract.cpp
+ */
+
+#include <ctype.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "../../../Arduino/V0p2_Main/RXCapture.h"
+
+static int hexVal(const char c)
+  {
+  if(isdigit((unsigned char)c)) { return(c - '0'); }
+  if(isxdigit((unsigned char)c)) { return(tolower((unsigned char)c) - 'a' + 10); }
+  return(-1);
+  }
+
+// Serial log to binary capture; returns count of bad lines.
+static unsigned long extract()
+  {
+  char line[1024];
+  uint8_t rec[RXCAP_HEADER_BYTES + 255];
+  unsigned long bad = 0;
+  while(NULL != fgets(line, sizeof(line), stdin))
+    {
+    if(RXCAP_SERIAL_PREFIX != line[0]) { continue; }
+    size_t n = 0;
+    const char *p = line + 1;
+    for( ; (hexVal(p[0]) >= 0) && (hexVal(p[1]) >= 0) && (n < sizeof(rec)); p += 2)
+      { rec[n++] = (uint8_t)((hexVal(p[0]) << 4) | hexVal(p[1])); }
+    // Drop lines mangled in transit, eg by a serial buffer overrun.
+    if((n < RXCAP_HEADER_BYTES) || (n != (size_t)RXCAP_HEADER_BYTES + rec[0]) || !((*p == '\0') || isspace((unsigned char)*p)))
+      { ++bad; continue; }
+    fwrite(rec, n, 1, stdout);
+    }
+  return(bad);
+  }
+
+// Binary capture to text listing.
+static void list()
+  {
+  uint8_t rec[RXCAP_HEADER_BYTES + 255];
+  while(1 == fread(rec, RXCAP_HEADER_BYTES, 1, stdin))
+    {
+    if((0 != rec[0]) && (1 != fread(rec + RXCAP_HEADER_BYTES, rec[0], 1, stdin))) { puts("!truncated"); return; }
+    const unsigned mins = (rec[4] << 8) | rec[5];
+    printf("%02u:%02u:%02u.%03u raw=%u kept=%u%s ",
+        mins / 60, mins % 60, rec[6], rec[7], rec[0], rec[1], (rec[2] & RXCAP_F_LOST) ? " lost" : "");
+    for(unsigned i = 0; i < rec[0]; ++i) { printf("%02x", rec[RXCAP_HEADER_BYTES + i]); }
+    putchar('\n');
+    }
+  }
+
+int main(const int argc, char *const argv[])
+  {
+  if((2 == argc) && (0 == strcmp(argv[1], "-l"))) { list(); return(0); }
+  if(1 != argc) { fprintf(stderr, "Usage: %s [-l] < input > output\n", argv[0]); return(1); }
+  const unsigned long bad = extract();
+  if(0 != bad) { fprintf(stderr, "%lu bad record lines skipped\n", bad); }
+  return(0);
+  }